@@ -0,0 +1,43 @@
+#ifndef CELLVALUE_H
+#define CELLVALUE_H
+
+#include <QString>
+
+// Типизированное значение ячейки. Разбирается один раз при загрузке
+// конфига/потока значений; отображение, стрелочные индикаторы и графики
+// берут число напрямую, без повторных toDouble() и регулярных выражений.
+struct CellValue {
+    enum Kind {
+        Empty,
+        Number,     // число
+        Duration,   // длительность "ч:м:с", number хранит секунды
+        Text        // произвольная строка (серийный номер и т.п.)
+    };
+
+    Kind kind = Empty;
+    double number = 0.0;
+    QString text;   // исходный текст (для строк и для сохранения в конфиг)
+
+    bool isEmpty() const { return kind == Empty; }
+    bool isNumeric() const { return kind == Number || kind == Duration; }
+
+    // Текст для отображения без единицы измерения
+    QString toString() const;
+
+    static CellValue fromNumber(double value);
+    static CellValue fromString(const QString& value);
+
+    bool operator==(const CellValue& other) const {
+        return kind == other.kind && number == other.number && text == other.text;
+    }
+    bool operator!=(const CellValue& other) const { return !(*this == other); }
+};
+
+// Реестр единиц измерения: строка единицы -> компактный числовой id.
+// Потокобезопасен, id стабильны в течение работы процесса (0 - без единицы).
+namespace Units {
+    int idFor(const QString& unit);
+    QString name(int id);
+}
+
+#endif // CELLVALUE_H
@@ -8,11 +8,37 @@
 #include <QJsonArray>
 #include <QJsonDocument>
 #include <QFileInfo>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+#include <memory>
+#include "cellvalue.h"
+
+// Цветная полоса шкалы стрелочного индикатора
+struct GaugeBand {
+    double from = 0;
+    double to = 0;
+    QString color;      // "#rrggbb" или имя цвета
+};
+
+// Шкала индикатора: "gauge": {"min": 0, "max": 120, "segments": [{"from": 0, "to": 20, "color": "#0000ff"}, ...]}
+struct GaugeConfig {
+    double min = 0;
+    double max = 0;
+    QList<GaugeBand> segments;
+
+    bool isValid() const { return max > min; }
+};
 
 struct CellInfo {
+    QString id;         // Стабильный идентификатор ячейки (поле "id" или путь "кол/яч[/подъяч]")
+    int channel = -1;   // Номер канала по id (Channels::idFor), индекс в массивах GUI и истории
     QString content;
-    QString value;      // Текущее значение для отображения
+    CellValue value;    // Текущее значение (разобрано при загрузке)
     QString unit;       // Единица измерения
+    int unitId = 0;     // id единицы в реестре Units
+    int historyCapacity = 0; // "historyCapacity": емкость истории канала (0 - общая)
+    GaugeConfig gauge;  // своя шкала индикатора (если не задана - общая из корня)
     QList<CellInfo> subCells; // Рекурсивная структура для вложенных ячеек
 };
 
@@ -22,6 +48,55 @@ struct ColumnConfig {
     QList<CellInfo> cells;
 };
 
+// Общие настройки из корня конфига
+struct ConfigOptions {
+    static constexpr int DefaultUiMaxRate = 30;   // перерисовок в секунду без "ui.maxRate"
+
+    int historyCapacity = 0;   // "history": {"capacity": N} - отсчетов на канал (0 - по умолчанию)
+    GaugeConfig gauge;         // "gauge": шкала индикаторов по умолчанию
+    int uiMaxRate = 0;         // "ui": {"maxRate": N} - перерисовок окна в секунду (0 - по умолчанию)
+    QString ingestOverflow;    // "ingest": {"overflow": "dropOldest" | "dropNewest" | "coalesce"}
+    QString ingestSocket;      // "ingest": {"socket": "имя"} - локальный сокет для производителей
+    int ingestUdpPort = 0;     // "ingest": {"udpPort": N} - UDP на 127.0.0.1 (0 - выключен)
+    QString ingestShm;         // "ingest": {"shm": "путь"} - разделяемое кольцо ShmRing
+};
+
+// Положение ячейки в дереве колонок (sub = -1 для основной ячейки)
+struct CellRef {
+    int col = -1;
+    int cell = -1;
+    int sub = -1;
+};
+
+// Индекс для привязки потока значений: UTF-8 id ячейки -> положение
+using CellIndex = QHash<QByteArray, CellRef>;
+
+// Реестр каналов: id ячейки -> плотный номер канала.
+// Номер выдается при первом появлении id и не меняется до конца работы процесса,
+// даже если ячейку переставили в другую колонку. Потокобезопасен.
+namespace Channels {
+    int idFor(const QString& cellId);
+    QString key(int channel);
+    int count();
+}
+
+// Неизменяемый снимок разобранной конфигурации.
+// Создается потоком IngestWorker (или самим ConfigManager при правке) и
+// передается в GUI указателем без копирования; после публикации не меняется.
+struct ConfigSnapshot {
+    QList<ColumnConfig> columns;
+    ConfigOptions options;
+    QString sourcePath;
+    qint64 timestamp = 0;   // время данных (от производителя или время приема), мс с эпохи
+
+    // Отличие от предыдущего снимка: каналы ячеек с новым значением или единицей.
+    // При layoutChanged структура другая и список не используется.
+    QVector<int> changedChannels;
+    bool layoutChanged = false;
+};
+
+using ConfigSnapshotPtr = std::shared_ptr<const ConfigSnapshot>;
+
 class ConfigManager : public QObject
 {
     Q_OBJECT
@@ -30,14 +105,67 @@ public:
     explicit ConfigManager(QObject *parent = nullptr);
 
     bool loadConfig(const QString& filename);
+    // Разбор уже прочитанного содержимого (filename - только для логов и configPath)
+    bool loadConfigData(const QByteArray& data, const QString& filename);
+    // Потокобезопасный разбор без изменения состояния (используется из IngestWorker).
+    // Основной путь - потоковый JsonStreamReader без DOM; *Dom-варианты через
+    // QJsonDocument оставлены для сравнения (tools/configbench).
+    // timestamp - поле "timestamp" корня (мс с эпохи), 0 если производитель его не указал.
+    static bool parseConfig(const QByteArray& data, const QString& filename, QList<ColumnConfig>& result,
+                            ConfigOptions* options = nullptr, qint64* timestamp = nullptr);
+    static bool parseConfigDom(const QByteArray& data, const QString& filename, QList<ColumnConfig>& result,
+                               ConfigOptions* options = nullptr, qint64* timestamp = nullptr);
+    // Применение готового снимка (только из GUI потока): снимок становится текущим без копирования
+    void applySnapshot(const ConfigSnapshotPtr& snapshot);
+
+    // Текущая конфигурация - неизменяемый снимок. Указатель можно держать сколько
+    // угодно: правки и новые данные не меняют его, а устанавливают новый снимок
+    ConfigSnapshotPtr snapshot() const { return current; }
+    // Номер текущего снимка, растет при каждой замене: дешевая проверка "что-то изменилось"
+    quint64 generation() const { return currentGeneration; }
+
+    // Поток только значений: {"values": {"<id>": число или строка, ...}}
+    // (null очищает значение, как в JSON merge patch) или список изменений
+    // [{"id": ..., "value": ...}, ...] - массивом или в поле "delta".
+    // Значения привязываются к уже загруженной разметке по стабильным id.
+    static CellIndex buildCellIndex(const QList<ColumnConfig>& columns);
+    static int applyValues(const QByteArray& data, const CellIndex& index,
+                           QList<ColumnConfig>& columns, qint64* timestamp = nullptr);
+    static int applyValuesDom(const QByteArray& data, const CellIndex& index,
+                              QList<ColumnConfig>& columns, qint64* timestamp = nullptr);
+
+    // Двоичный кадр значений (little-endian) для производителей без JSON:
+    //   quint32 BinaryValuesMagic ("HUIB"), quint32 длина остатка кадра,
+    //   qint64 время (мс с эпохи, 0 - время приема), quint16 число значений,
+    //   на каждое значение: quint16 длина id, id в UTF-8, double значение
+    static constexpr quint32 BinaryValuesMagic = 0x42495548;
+    static constexpr int BinaryValuesHeader = 8;    // магия и длина
+    static int applyBinaryValues(const QByteArray& frame, const CellIndex& index,
+                                 QList<ColumnConfig>& columns, qint64* timestamp = nullptr);
+    // Ячейка или подъячейка по положению; nullptr, если такой нет
+    static CellInfo* cellAt(QList<ColumnConfig>& columns, const CellRef& ref);
+
+    // Сравнение значений двух деревьев: каналы изменившихся ячеек дописываются в changedChannels.
+    // false - структура (колонки, ячейки, подъячейки, id) различается.
+    static bool diffValues(const QList<ColumnConfig>& before, const QList<ColumnConfig>& after,
+                           QVector<int>& changedChannels);
+    // Положение каждого канала в дереве (col = -1 для каналов без ячейки)
+    static QVector<CellRef> buildChannelRefs(const QList<ColumnConfig>& columns);
+
+    // Идентификаторы по умолчанию для ячеек без явного "id" и номера каналов
+    static QString defaultCellId(int col, int cell, int sub = -1);
+    static void assignDefaultIds(QList<ColumnConfig>& columns);
     bool saveConfig(const QString& filename) const;
     bool configExists() const;
 
     // Геттеры
-    int getColumnCount() const { return columns.size(); }
-    QList<ColumnConfig> getColumns() const { return columns; }
+    // Ссылки действительны, пока не установлен следующий снимок; дольше - через snapshot()
+    int getColumnCount() const { return current->columns.size(); }
+    const QList<ColumnConfig>& getColumns() const { return current->columns; }
     QStringList getColumnNames() const;
     QList<int> getCellCounts() const;
+    const ConfigOptions& getOptions() const { return current->options; }
+    qint64 getDataTimestamp() const { return current->timestamp; }
 
     // Методы для работы со значениями
     bool updateCellValue(int columnIndex, int cellIndex, const QString& value);
@@ -56,13 +184,20 @@ public:
     void setConfigPath(const QString& path) { configPath = path; }
 
 private:
-    QList<ColumnConfig> columns;
+    // Правка: копия текущего снимка (списки неявно разделяемые, поэтому глубоко
+    // копируется только путь к измененной ячейке), затем установка как нового
+    std::shared_ptr<ConfigSnapshot> editableCopy() const;
+    void install(const ConfigSnapshotPtr& next);
+
+    ConfigSnapshotPtr current;
+    quint64 currentGeneration = 0;
     QString configPath;
 
-    ColumnConfig columnFromJson(const QJsonObject& json);
+    static ColumnConfig columnFromJson(const QJsonObject& json);
     QJsonObject columnToJson(const ColumnConfig& column) const;
-    CellInfo cellFromJson(const QJsonObject& json);
+    static CellInfo cellFromJson(const QJsonObject& json);
     QJsonObject cellToJson(const CellInfo& cell) const;
+    static CellValue valueFromJson(const QJsonValue& val);
 };
 
 #endif // CONFIGMANAGER_H
@@ -0,0 +1,67 @@
+#ifndef DASHBOARDMODEL_H
+#define DASHBOARDMODEL_H
+
+#include <QAbstractItemModel>
+#include <QStyledItemDelegate>
+#include <QList>
+#include "configmanager.h"
+
+// Конфигурация как дерево: колонки -> ячейки -> подъячейки.
+// Используется компактным представлением (QTreeView + DashboardDelegate),
+// которое создает и рисует только видимые строки, поэтому стоимость
+// не зависит от размера конфига. Модель читает прямо из неизменяемого
+// снимка конфигурации и ничего из него не копирует.
+class DashboardModel : public QAbstractItemModel
+{
+    Q_OBJECT
+public:
+    enum Roles {
+        ValueTextRole = Qt::UserRole + 1,   // значение с единицей измерения
+        IdRole,                             // стабильный id ячейки
+        ChannelRole,                        // номер канала ячейки
+        LevelRole                           // 0 - колонка, 1 - ячейка, 2 - подъячейка
+    };
+
+    explicit DashboardModel(QObject *parent = nullptr);
+
+    // Полная замена структуры (сброс модели); nullptr - пустая модель
+    void setSnapshot(const ConfigSnapshotPtr& snapshot);
+    // Переход на снимок с той же структурой: dataChanged только для изменившихся ячеек.
+    // Если структура другая - полный сброс.
+    void updateValues(const ConfigSnapshotPtr& snapshot);
+    // Переход на снимок той же структуры, в котором изменились только ячейки
+    // changed: dataChanged без обхода всего дерева. Структуру гарантирует
+    // вызывающий (после смены разметки - setSnapshot/updateValues)
+    void updateCells(const ConfigSnapshotPtr& snapshot, const QVector<CellRef>& changed);
+
+    // Положение ячейки для индекса (col = -1 для недействительного)
+    CellRef cellRef(const QModelIndex& index) const;
+
+    QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const override;
+    QModelIndex parent(const QModelIndex& child) const override;
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+
+private:
+    const CellInfo* cellAt(const CellRef& ref) const;
+    QModelIndex indexFor(const CellRef& ref) const;
+    bool sameStructure(const QList<ColumnConfig>& other) const;
+    const QList<ColumnConfig>& columns() const;
+
+    ConfigSnapshotPtr config;
+};
+
+// Рисует строку модели как карточку ячейки: название слева, значение справа.
+// Без виджетов и таблиц стилей - только QPainter для видимых строк.
+class DashboardDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit DashboardDelegate(QObject *parent = nullptr);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+    QSize sizeHint(const QStyleOptionViewItem& option, const QModelIndex& index) const override;
+};
+
+#endif // DASHBOARDMODEL_H
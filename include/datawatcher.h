@@ -0,0 +1,60 @@
+#ifndef DATAWATCHER_H
+#define DATAWATCHER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QDateTime>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Следит за файлом с данными и сообщает только о реальных изменениях.
+// Основной источник событий - QFileSystemWatcher (файл и его каталог,
+// чтобы ловить атомарную замену через rename). Резервный таймер раз в
+// pollInterval делает дешевую проверку mtime/size. Файл читается только
+// если mtime или размер изменились, а сигнал отправляется только если
+// изменился хеш содержимого.
+class DataWatcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DataWatcher(QObject *parent = nullptr);
+
+    void setPath(const QString& path);
+    QString path() const { return filePath; }
+
+    // Задержка для склейки пачки событий одной записи (мс)
+    void setDebounceInterval(int ms);
+    // Период резервного опроса (мс), 0 - отключить
+    void setPollInterval(int ms);
+
+public slots:
+    // Проверка отпечатка файла; читает файл только при изменении mtime/size
+    void check();
+
+signals:
+    void dataChanged(const QByteArray& data);
+
+private slots:
+    void onPathChanged(const QString& path);
+
+private:
+    struct Fingerprint {
+        QDateTime modified;
+        qint64 size = -1;
+        size_t hash = 0;
+        bool valid = false;
+    };
+
+    void updateWatchedPaths();
+
+    QString filePath;
+    QFileSystemWatcher *watcher;
+    QTimer *debounceTimer;
+    QTimer *pollTimer;
+    Fingerprint last;
+};
+
+#endif // DATAWATCHER_H
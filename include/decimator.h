@@ -0,0 +1,44 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <QVector>
+#include <QPointF>
+
+// Прореживание ряда для графика по алгоритму M4.
+// Диапазон [from, to] делится на buckets интервалов (по одному на пиксель),
+// в каждом остаются только первая, последняя, минимальная и максимальная точки.
+// Линия, нарисованная по ним, попиксельно совпадает с линией по всем точкам,
+// пики не теряются, а стоимость отрисовки ограничена шириной графика.
+//
+// Точки подаются потоком по возрастанию времени через add(), поэтому
+// источник (кольцевой буфер, сегменты архива) не нужно копировать целиком.
+class M4Decimator
+{
+public:
+    M4Decimator(double from, double to, int buckets);
+
+    void add(double x, double y);
+    void add(const QPointF& point) { add(point.x(), point.y()); }
+
+    // Оставшиеся точки по возрастанию времени
+    QVector<QPointF> result() const;
+
+    // Прореживание уже собранного ряда; короткий ряд возвращается как есть
+    static QVector<QPointF> decimate(const QVector<QPointF>& data, int buckets);
+
+private:
+    struct Bucket {
+        QPointF first;
+        QPointF last;
+        QPointF min;
+        QPointF max;
+        bool used = false;
+    };
+
+    double from;
+    double to;
+    double width;   // ширина интервала по x
+    QVector<Bucket> bucketData;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,70 @@
+#ifndef GORILLACHUNK_H
+#define GORILLACHUNK_H
+
+#include <QByteArray>
+#include <QtGlobal>
+
+// Сжатый блок истории в стиле Gorilla (Facebook TSDB).
+// Отсчет RLE (начало, конец плато, значение) кодируется битовым потоком:
+//  - время начала - разность разностей (delta-of-delta), при ровном
+//    периоде опроса это 1 бит;
+//  - длительность плато - разность с предыдущей тем же кодом;
+//  - значение - XOR с предыдущим double, хранятся только значащие биты.
+// На медленно меняющейся телеметрии выходит порядка 1-2 байт на отсчет
+// вместо 24 байт Sample. Блок только дописывается и читается
+// последовательно через Reader.
+class GorillaChunk
+{
+public:
+    GorillaChunk();
+
+    void append(qint64 timestamp, qint64 until, double value);
+    void squeeze() { bytes.squeeze(); }   // после закрытия блока
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+    qint64 firstTimestamp() const { return first; }
+    qint64 lastUntil() const { return last; }
+    qint64 memoryUsage() const { return sizeof(GorillaChunk) + bytes.capacity(); }
+
+    class Reader
+    {
+    public:
+        explicit Reader(const GorillaChunk& chunk);
+        bool next(qint64* timestamp, qint64* until, double* value);
+
+    private:
+        quint64 readBits(int n);
+        qint64 readDelta();
+
+        const GorillaChunk& chunk;
+        qint64 bitPos = 0;
+        int index = 0;
+        qint64 prevTimestamp = 0;
+        qint64 prevDelta = 0;
+        qint64 prevDuration = 0;
+        quint64 prevValue = 0;
+        int prevLeading = 0;
+        int prevTrailing = 0;
+    };
+
+private:
+    void writeBits(quint64 value, int n);
+    void writeDelta(qint64 delta);
+
+    QByteArray bytes;
+    qint64 bitCount;
+    int count;
+    qint64 first;
+    qint64 last;
+
+    // Состояние кодера
+    qint64 prevTimestamp;
+    qint64 prevDelta;
+    qint64 prevDuration;
+    quint64 prevValue;
+    int prevLeading;    // -1 - окна значащих бит еще нет
+    int prevTrailing;
+};
+
+#endif // GORILLACHUNK_H
@@ -5,9 +5,11 @@
 #include <QChartView>
 #include <QLineSeries>
 #include <QValueAxis>
+#include <QDateTimeAxis>
 #include <QChart>
 #include <QVBoxLayout>
 #include <QString>
+#include <QPointF>
 
 class GraphWidget : public QWidget
 {
@@ -15,17 +17,45 @@ class GraphWidget : public QWidget
 public:
     explicit GraphWidget(QWidget *parent = nullptr);
 
-    // Обновление данных графика
-    void setData(const QVector<double> &data, const QString &cellName);
+    // Обновление данных графика: x - время в мс с эпохи, y - значение.
+    // Ряд длиннее нескольких точек на пиксель прореживается (M4)
+    void setData(const QVector<QPointF> &data, const QString &cellName);
+
+    // Дописывание новых точек (x больше последней) без перестроения ряда:
+    // стоимость O(новых точек), границы осей ведутся нарастающим итогом.
+    // false - точек на графике стало больше бюджета, нужен setData()
+    bool appendData(const QVector<QPointF> &points);
+    int pointCount() const { return series->count(); }
+
+    // Ширина области построения в пикселях - число интервалов прореживания
+    int plotWidth() const;
+
+    // Уровень истории (TimeSeriesStore::Tier) для видимого диапазона [from, to], мс:
+    // самый грубый, у которого агрегатов не меньше, чем пикселей по ширине
+    int pickTier(qint64 from, qint64 to) const;
+
+signals:
+    void widthChanged(int plotWidth);
+
+protected:
+    void resizeEvent(QResizeEvent *event) override;
 
 private:
     QChart *chart;
     QLineSeries *series;
     QChartView *chartView;
-    QValueAxis *axisX;
+    QDateTimeAxis *axisX;
     QValueAxis *axisY;
     QVBoxLayout *layout;
+    int lastWidth = 0;
+
+    // Границы данных для автомасштаба
+    double minX = 0, maxX = 0;
+    double minY = 0, maxY = 0;
+    bool hasData = false;
+
+    void includePoint(const QPointF &point);
+    void applyRanges();
 };
 
 #endif // GRAPHWIDGET_H
-
@@ -0,0 +1,172 @@
+#ifndef HISTORYARCHIVE_H
+#define HISTORYARCHIVE_H
+
+#include <QString>
+#include <QHash>
+#include <QFile>
+#include <QList>
+#include <QVector>
+#include <memory>
+
+// Запись архива фиксированного размера
+struct ArchiveRecord {
+    qint64 timestamp;   // мс с эпохи
+    double value;
+};
+static_assert(sizeof(ArchiveRecord) == 16, "ArchiveRecord must stay 16 bytes on disk");
+
+// Сегмент архива, отображенный в память только для чтения.
+// Записи не копируются: records() указывает прямо в отображение файла.
+class ArchiveSegment
+{
+public:
+    ArchiveSegment() = default;
+    ~ArchiveSegment();
+    ArchiveSegment(const ArchiveSegment&) = delete;
+    ArchiveSegment& operator=(const ArchiveSegment&) = delete;
+
+    bool open(const QString& path);
+
+    const ArchiveRecord* records() const { return data; }
+    qint64 count() const { return recordCount; }
+    qint64 fileSize() const { return mappedSize; }
+
+private:
+    QFile file;
+    uchar *map = nullptr;
+    const ArchiveRecord *data = nullptr;
+    qint64 recordCount = 0;
+    qint64 mappedSize = 0;
+};
+
+using ArchiveSegmentPtr = std::shared_ptr<ArchiveSegment>;
+
+// Агрегат записей сегмента за интервал [start, start + разрешение уровня)
+struct ArchiveRollup {
+    qint64 start;
+    double min;
+    double max;
+    double sum;
+    qint64 count;
+};
+static_assert(sizeof(ArchiveRollup) == 40, "ArchiveRollup must stay 40 bytes on disk");
+
+// Агрегаты закрытого сегмента за 1 с, 1 мин и 1 ч - файл "<начало, мс>.rollup"
+// рядом с сегментом, отображенный в память. Строится один раз: при ротации
+// сегмента или при первом чтении сегмента, закрытого без него. Повтор
+// значения (heartbeat) в count и mean не входит, как и в TimeSeriesStore.
+class ArchiveRollups
+{
+public:
+    static constexpr int LevelCount = 3;
+    static constexpr qint64 Resolutions[LevelCount] = {1000, 60 * 1000, 3600 * 1000};
+
+    ArchiveRollups() = default;
+    ~ArchiveRollups();
+    ArchiveRollups(const ArchiveRollups&) = delete;
+    ArchiveRollups& operator=(const ArchiveRollups&) = delete;
+
+    // sourceRecords - сколько записей в сегменте: файл, построенный по
+    // другому числу записей, считается устаревшим
+    bool open(const QString& path, qint64 sourceRecords);
+    static bool build(const ArchiveSegment& segment, const QString& path);
+    // Уровень для разрешения в мс, -1 - такого нет
+    static int levelFor(qint64 resolution);
+
+    const ArchiveRollup* records(int level) const { return data[level]; }
+    qint64 count(int level) const { return counts[level]; }
+
+private:
+    QFile file;
+    uchar *map = nullptr;
+    const ArchiveRollup *data[LevelCount] = {};
+    qint64 counts[LevelCount] = {};
+};
+
+using ArchiveRollupsPtr = std::shared_ptr<ArchiveRollups>;
+
+// Постоянная история на диске.
+// Для каждого канала - каталог с сегментами "<начало, мс>.seg": заголовок
+// и записи ArchiveRecord, только дозапись. append() только кладет запись
+// в буфер файла, на диск пачка уходит в flush() - один раз на порцию
+// отсчетов. При падении процесса теряется только несброшенная пачка, а
+// неполная запись в хвосте отрезается при следующем открытии сегмента.
+// flush() не ждет носителя (fsync): он вызывается на каждую порцию, и
+// синхронная запись стоила бы дороже самой истории. На носитель сегмент
+// сбрасывается при создании (заголовок) и при ротации, поэтому при
+// отключении питания может пропасть хвост только текущего сегмента.
+// Сегменты ротируются по размеру и по длительности; у закрытого сегмента
+// есть файл агрегатов (ArchiveRollups), поэтому обзор длинной истории не
+// читает сырые записи. Повтор значения пишется не чаще heartbeat, чтобы плато было видно без
+// записи каждого тика.
+class HistoryArchive
+{
+public:
+    static constexpr qint64 DefaultSegmentBytes = 4 * 1024 * 1024;
+    static constexpr qint64 DefaultSegmentSpanMs = 24LL * 3600 * 1000;
+    static constexpr qint64 DefaultHeartbeatMs = 60 * 1000;
+    // Сколько закрытых сегментов держать отображенными (вытесняются давно не читавшиеся)
+    static constexpr int MaxMappedSegments = 256;
+
+    HistoryArchive();
+    ~HistoryArchive();
+    HistoryArchive(const HistoryArchive&) = delete;
+    HistoryArchive& operator=(const HistoryArchive&) = delete;
+
+    void setRootPath(const QString& path);
+    QString rootPath() const { return root; }
+    void setRotation(qint64 maxSegmentBytes, qint64 segmentSpanMs);
+    void setHeartbeat(qint64 ms) { heartbeatMs = ms; }
+
+    // ch - номер канала (Channels), по нему писатель находится без поиска;
+    // key - id ячейки, от которого зависит каталог на диске
+    void append(int ch, const QString& key, qint64 timestamp, double value);
+    // Сбросить на диск записи, накопленные append() с прошлого раза
+    void flush();
+
+    // Сегменты канала, пересекающиеся с [from, to], в порядке времени.
+    // Закрытые сегменты отображаются один раз и кешируются.
+    QList<ArchiveSegmentPtr> segments(int ch, const QString& key, qint64 from, qint64 to);
+
+    // Время первой и последней записи канала на диске; false - архива нет
+    bool timeRange(int ch, const QString& key, qint64* from, qint64* to);
+
+    // Агрегаты закрытых сегментов, пересекающихся с [from, to], в порядке времени.
+    // *sealedEnd - начало первого незакрытого сегмента: данные начиная с него
+    // есть только сырыми (segments())
+    QList<ArchiveRollupsPtr> rollups(int ch, const QString& key, qint64 from, qint64 to, qint64* sealedEnd);
+
+private:
+    struct Writer {
+        QFile file;
+        qint64 segmentStart = 0;
+        qint64 size = 0;        // размер сегмента с учетом несброшенных записей
+        bool dirty = false;     // есть записи, не сброшенные на диск
+        qint64 lastTimestamp = 0;
+        double lastValue = 0.0;
+        bool hasLast = false;
+    };
+
+    QString channelDir(const QString& key) const;
+    Writer* writerFor(int ch, const QString& key);
+    bool openSegment(Writer* writer, const QString& key, qint64 start);
+    ArchiveRollupsPtr loadRollups(const QString& dir, qint64 start);
+
+    QString root;
+    qint64 maxSegmentBytes;
+    qint64 segmentSpanMs;
+    qint64 heartbeatMs;
+
+    QVector<Writer*> writers;   // номер канала -> писатель (nullptr - еще не открыт)
+    QVector<Writer*> dirtyWriters;  // писатели с несброшенными записями
+    template <typename T>
+    struct Cached {
+        std::shared_ptr<T> item;
+        quint64 lastUse = 0;
+    };
+    QHash<QString, Cached<ArchiveSegment>> mappedSegments; // путь -> закрытый сегмент
+    QHash<QString, Cached<ArchiveRollups>> mappedRollups;  // путь -> его агрегаты
+    quint64 useClock = 0;                                  // счетчик обращений для вытеснения
+};
+
+#endif // HISTORYARCHIVE_H
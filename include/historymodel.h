@@ -0,0 +1,55 @@
+#ifndef HISTORYMODEL_H
+#define HISTORYMODEL_H
+
+#include <QAbstractTableModel>
+#include <QVector>
+#include "timeseriesstore.h"
+
+// История одного канала как таблица: строка - запись RLE (с, до, значение),
+// от самой старой к самой новой. Модель ничего не копирует из хранилища:
+// строки читаются по запросу представления, которое спрашивает только видимые.
+// Записи в сжатых блоках распаковываются поблочно, последний распакованный
+// блок кешируется, поэтому прокрутка соседних строк не декодирует заново.
+// refresh() переносит изменения хранилища инкрементально: новые записи -
+// вставкой строк в конец, вытесненные блоки - удалением строк из начала.
+class HistoryModel : public QAbstractTableModel
+{
+    Q_OBJECT
+public:
+    enum Column {
+        TimeColumn,
+        UntilColumn,
+        ValueColumn,
+        ColumnCount
+    };
+
+    explicit HistoryModel(const TimeSeriesStore& store, QObject *parent = nullptr);
+
+    // Смена канала - полный сброс модели; -1 - пустая таблица
+    void setChannel(int channel);
+    int channel() const { return ch; }
+
+    // Догнать хранилище после добавления отсчетов
+    void refresh();
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex& parent = QModelIndex()) const override;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+private:
+    bool sampleAt(int row, Sample* sample) const;
+    bool chunkSample(const GorillaChunk& chunk, qint64 chunkFirst, int offset, Sample* sample) const;
+
+    const TimeSeriesStore& store;
+    int ch = -1;
+    qint64 first = 0;   // сквозной номер записи в строке 0
+    int rows = 0;
+
+    // Последний распакованный блок: сквозной номер первой записи и размер
+    mutable qint64 cacheFirst = -1;
+    mutable int cacheSize = 0;
+    mutable QVector<Sample> cache;
+};
+
+#endif // HISTORYMODEL_H
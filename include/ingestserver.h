@@ -0,0 +1,56 @@
+#ifndef INGESTSERVER_H
+#define INGESTSERVER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+
+class QLocalServer;
+class QLocalSocket;
+class QUdpSocket;
+
+// Прием значений от производителей без файла: локальный сокет (Unix domain
+// socket / именованный канал) и UDP на 127.0.0.1. Сервер только режет поток
+// на сообщения; сами сообщения - те же форматы, что понимает ConfigManager:
+//   - строка JSON, как values.json: {"timestamp": ..., "values": {"<id>": ...}}\n
+//   - двоичный кадр ConfigManager::applyBinaryValues ("HUIB" + длина + значения).
+// Клиентов локального сокета может быть сколько угодно, у каждого свой буфер.
+// UDP-датаграмма - один двоичный кадр или одна/несколько строк JSON.
+// Все сообщения, пришедшие за одно событие чтения, отдаются одним сигналом,
+// чтобы из пачки получился один снимок.
+class IngestServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Длиннее сообщение не бывает; клиент с таким мусором отключается
+    static constexpr int MaxMessageSize = 1 << 20;
+
+    explicit IngestServer(QObject *parent = nullptr);
+
+    // Пустое имя / порт 0 - соответствующий вход выключен.
+    // Повторный вызов с теми же параметрами ничего не делает
+    void listen(const QString& socketName, int udpPort);
+
+signals:
+    void messagesReceived(const QList<QByteArray>& messages);
+
+private slots:
+    void onNewConnection();
+    void onLocalReadyRead();
+    void onUdpReadyRead();
+
+private:
+    // Отрезает из buffer все целые сообщения; false - поток испорчен
+    static bool takeMessages(QByteArray& buffer, QList<QByteArray>& out);
+
+    QLocalServer *localServer = nullptr;
+    QUdpSocket *udpSocket = nullptr;
+    QString localName;
+    int udpPort = 0;
+    QHash<QLocalSocket*, QByteArray> buffers;   // недочитанный хвост по клиенту
+};
+
+#endif // INGESTSERVER_H
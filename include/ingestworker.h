@@ -0,0 +1,127 @@
+#ifndef INGESTWORKER_H
+#define INGESTWORKER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <atomic>
+#include "configmanager.h"
+#include "samplequeue.h"
+#include "shmingest.h"
+
+class DataWatcher;
+class IngestServer;
+class JournalTailer;
+class QTimer;
+
+// Фоновый прием данных: чтение файла, разбор JSON и построение
+// неизменяемого ConfigSnapshot выполняются в отдельном потоке.
+// Готовые снимки копятся в очереди; GUI забирает их все разом через
+// takeSnapshots() и пишет каждый в историю, а перерисовывает окно
+// не чаще своей частоты кадров. Если GUI надолго отстал и очередь
+// заполнена, последний незабранный снимок заменяется новым, а списки
+// изменившихся ячеек сливаются.
+//
+// Числовые значения для истории идут отдельно от снимков - компактными
+// отсчетами через очередь без блокировок (SampleQueue). Каждый отсчет
+// кладется в очередь до публикации своего снимка, поэтому GUI, забрав
+// снимки, находит в очереди все их отсчеты. Политика переполнения -
+// "ingest": {"overflow": ...} из разметки.
+//
+// Источников два: файл разметки (полное дерево columns/cells/subCells)
+// и необязательный файл только значений {"values": {"<id>": ...}}.
+// Значения накладываются на последнюю загруженную разметку по id ячеек,
+// поэтому производителю достаточно переписывать маленький файл значений.
+// Те же значения (JSON-строки или двоичные кадры) можно слать без файла -
+// в локальный сокет или UDP на loopback (IngestServer, "ingest" в разметке),
+// или дописывать строками в журнал, который читается с последнего смещения
+// (JournalTailer). Журнал, существовавший при старте, проигрывается целиком
+// и публикуется одним снимком с последними значениями.
+// Самые частые каналы процесс сбора может писать в разделяемое кольцо
+// (ShmRing): воркер читает его с частотой кадров окна, все отсчеты идут
+// в историю, а в ячейки - последнее значение канала.
+class IngestWorker : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IngestWorker(QObject *parent = nullptr);
+
+    static constexpr int MaxPendingSnapshots = 1024;
+
+    // Забрать все опубликованные с прошлого раза снимки в порядке поступления.
+    // Вызывается из GUI потока.
+    QList<ConfigSnapshotPtr> takeSnapshots();
+
+    // Забрать накопленные отсчеты (дописываются в out). Вызывается из GUI потока
+    void takeSamples(QVector<SampleRecord>& out);
+    // Отсчеты, потерянные при переполнении очереди или разделяемого кольца
+    quint64 droppedSamples() const { return samples.droppedCount() + shm.droppedCount(); }
+
+public slots:
+    // Запуск слежения за файлами (вызывать в потоке воркера).
+    // valuesPath и journalPath могут быть пустыми - тогда используется только разметка.
+    void start(const QString& layoutPath, const QString& valuesPath = QString(),
+               const QString& journalPath = QString());
+
+signals:
+    // Появился новый снимок; при пачке снимков отправляется один раз
+    void snapshotReady();
+
+private slots:
+    void onLayoutChanged(const QByteArray& data);
+    void onValuesChanged(const QByteArray& data);
+    // Журнал, существовавший при старте: строки сворачиваются в один снимок
+    void onJournalReplayed(const QList<QByteArray>& lines);
+    void onJournalReplayFinished();
+
+private:
+    // Перед публикацией снимок еще изменяем: при переполнении очереди к нему
+    // добавляются изменения вытесненного снимка.
+    // pushValues = false - отсчеты снимка уже в очереди (разделяемое кольцо)
+    void publish(const std::shared_ptr<ConfigSnapshot>& snapshot, bool pushValues = true);
+    // Отсчеты снимка в очередь: после смены разметки - всех числовых ячеек,
+    // иначе только изменившихся
+    void pushSamples(const ConfigSnapshot& snapshot);
+    // Применить пачку сообщений значений (JSON или двоичных) к текущему снимку
+    void applyMessages(const QList<QByteArray>& messages);
+    // Снимок только с новыми значениями: сравнение с текущим и публикация
+    void publishValues(const std::shared_ptr<ConfigSnapshot>& snapshot, qint64 timestamp,
+                       bool pushValues = true);
+    // Настройка источников из "ingest" разметки
+    void configureSources(const ConfigOptions& options);
+    // Новые отсчеты из разделяемого кольца
+    void pollShm();
+
+    DataWatcher *layoutWatcher;
+    DataWatcher *valuesWatcher;
+    JournalTailer *journalTailer;
+    IngestServer *server;
+    QString sourcePath;
+    QString journalPath;    // журнал открывается после первой разметки
+
+    // Проигрываемый журнал: последние значения всех его строк
+    std::shared_ptr<ConfigSnapshot> journalReplay;
+    qint64 journalReplayTimestamp = 0;
+
+    // Состояние потока воркера: последняя разметка и привязка id -> ячейка
+    ConfigSnapshotPtr current;
+    CellIndex cellIndex;
+    QVector<CellRef> channelRefs;   // номер канала -> положение ячейки
+    QByteArray lastValues;
+
+    QMutex pendingMutex;
+    QList<ConfigSnapshotPtr> pending;   // опубликованные, но еще не забранные GUI
+    std::atomic_bool notifyPending{false};
+
+    SampleQueue samples;
+
+    ShmIngest shm;
+    QTimer *shmTimer;
+    QVector<SampleRecord> shmBuffer;
+};
+
+#endif // INGESTWORKER_H
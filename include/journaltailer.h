@@ -0,0 +1,69 @@
+#ifndef JOURNALTAILER_H
+#define JOURNALTAILER_H
+
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+
+class QFileSystemWatcher;
+class QTimer;
+
+// Чтение журнала, в который производитель только дописывает строки
+// (по одному обновлению значений на строку). В отличие от DataWatcher
+// файл не перечитывается целиком: запоминается смещение прочитанного,
+// и при изменении читаются только дописанные байты, поэтому ввод-вывод
+// пропорционален объему изменений, а не размеру журнала.
+//
+// Уже существующий при старте журнал сначала проигрывается целиком:
+// строки порциями отдаются в linesReplayed(), в конце - replayFinished(),
+// чтобы получатель свернул их в одно состояние (важно только последнее
+// значение каждой ячейки), а не публиковал каждую строку. Дальше - только
+// дописанное. Журнал, появившийся позже, читается с начала. Если файл стал
+// короче прочитанного или по пути лежит уже другой файл (ротация, замена:
+// другие устройство и inode, вне Unix - время создания), чтение
+// начинается заново.
+// Недописанная последняя строка ждет своего '\n'.
+class JournalTailer : public QObject
+{
+    Q_OBJECT
+
+public:
+    // Длиннее строка не бывает; такой хвост без '\n' отбрасывается
+    static constexpr int MaxLineSize = 1 << 20;
+    // Порция чтения при проигрывании журнала при старте
+    static constexpr int ReplayChunkSize = 4 << 20;
+
+    explicit JournalTailer(QObject *parent = nullptr);
+
+    void setPath(const QString& path);
+    QString path() const { return filePath; }
+
+    // Период резервного опроса (мс), 0 - отключить
+    void setPollInterval(int ms);
+
+public slots:
+    // Прочитать дописанное с прошлого раза
+    void check();
+
+signals:
+    void linesAppended(const QList<QByteArray>& lines);
+    // Проигрывание журнала, существовавшего при старте
+    void linesReplayed(const QList<QByteArray>& lines);
+    void replayFinished();
+
+private:
+    void updateWatchedPaths();
+    void replay(qint64 size);
+    // Дописать прочитанное к недописанной строке и забрать полные строки
+    QList<QByteArray> takeLines(const QByteArray& chunk);
+
+    QString filePath;
+    QFileSystemWatcher *watcher;
+    QTimer *pollTimer;
+    qint64 offset = -1;     // прочитано байт; -1 - файл еще не видели
+    QByteArray partial;     // начало недописанной строки
+    QByteArray identity;    // идентичность читаемого файла (fileIdentity)
+};
+
+#endif // JOURNALTAILER_H
@@ -0,0 +1,84 @@
+#ifndef JSONSTREAMREADER_H
+#define JSONSTREAMREADER_H
+
+#include <QByteArray>
+#include <QByteArrayView>
+#include <QString>
+#include <QVarLengthArray>
+
+// Потоковый (pull, SAX-подобный) разборщик JSON без построения DOM.
+// Читает UTF-8 буфер по одному токену; ключи и строки без escape-
+// последовательностей отдаются как QByteArrayView прямо в исходный буфер,
+// поэтому сравнение ключей и поиск по id не выделяют память.
+// Разделители проверяются так же строго, как в QJsonDocument: ровно одно
+// ':' после ключа и ровно одна ',' между элементами, без запятой перед
+// закрывающей скобкой и без данных после корневого значения.
+// Буфер data должен жить дольше читателя.
+class JsonStreamReader
+{
+public:
+    enum Token {
+        Invalid,
+        BeginObject,
+        EndObject,
+        BeginArray,
+        EndArray,
+        Key,
+        String,
+        Number,
+        Bool,
+        Null,
+        End
+    };
+
+    explicit JsonStreamReader(const QByteArray& data);
+
+    Token next();
+    Token token() const { return current; }
+    bool hasError() const { return current == Invalid; }
+    int depth() const { return stack.size(); }
+
+    // Текст текущего ключа/строки (UTF-8, escape уже раскрыты).
+    // Действителен до следующего вызова next().
+    QByteArrayView text() const { return textView; }
+    bool textEquals(const char *latin1) const { return textView == QByteArrayView(latin1); }
+    QString stringValue() const { return QString::fromUtf8(textView); }
+
+    double numberValue() const { return number; }
+    bool boolValue() const { return boolean; }
+
+    // Пропустить значение, которое только что было прочитано как токен.
+    // Для BeginObject/BeginArray пропускает все до парного закрытия.
+    bool skipCurrent();
+
+private:
+    bool readString();
+    bool readNumber();
+    bool readLiteral(const char *literal, int length);
+    void skipWhitespace();
+    void valueDone();
+
+    const char *pos;
+    const char *end;
+
+    Token current;
+    QByteArrayView textView;
+    QByteArray scratch;         // буфер для строк с escape-последовательностями
+    double number;
+    bool boolean;
+
+    // Что допустимо следующим токеном
+    enum Expect {
+        ExpectValue,        // значение (корень, после ':' или ',' в массиве)
+        ExpectFirstValue,   // значение или ']' сразу после '['
+        ExpectKey,          // ключ после ',' в объекте
+        ExpectFirstKey,     // ключ или '}' сразу после '{'
+        ExpectComma,        // ',' или закрывающая скобка после элемента
+        ExpectEnd           // корневое значение прочитано, дальше только пробелы
+    };
+
+    QVarLengthArray<char, 16> stack; // '{' или '['
+    Expect expect;
+};
+
+#endif // JSONSTREAMREADER_H
@@ -8,15 +8,26 @@
 #include <QMap>
 #include <QStringList>
 #include <QTimer>
+#include <QElapsedTimer>
 #include <QTextEdit>
 #include "configmanager.h"
 #include <temperaturegause.h>
 #include "graphwidget.h"
+#include "ingestworker.h"
+#include "timeseriesstore.h"
+#include "historyarchive.h"
+#include "decimator.h"
 #include <QSplitter>
 class QPushButton;
+class QThread;
 class QScrollArea;
 class QWidget;
 class QLabel;
+class PlotWidget;
+class QTreeView;
+class DashboardModel;
+class HistoryModel;
+class QTableView;
 class MainWindow : public QMainWindow
 {
     Q_OBJECT
@@ -30,23 +41,67 @@ private slots:
     void createLayoutFromConfig();
     void loadConfig();
     void saveConfig();
-    void onCellClicked(int col, int cell, const QList<int>& subCellPath);
+    void onCellClicked(int channel);
     void updateTemperatureGauges();
-    void refreshData();  // обновление данных каждую секунду
-    void updateCellWidget(QWidget* cellWidget, const CellInfo& cellInfo); // рекурсивное обновление ячеек
+    void refreshData();  // прием снимков от IngestWorker: история сразу, окно - по кадрам
+    void flushUiUpdate(); // накопленные изменения на экран, не чаще uiInterval()
     void updateCellWidgets(); // обновление всех ячеек из конфига
+    void updateChangedCells(const QVector<int>& changedChannels); // только изменившиеся ячейки
+    void updateGraph();       // график выбранной ячейки, прореженный под ширину
+    void appendGraph();       // дописать на график только новые отсчеты
+    void updateOverlay();     // все каналы на одном графике
+    void setCompactView(bool compact); // дерево model/view вместо виджетов ячеек
 
 private:
     QSplitter *mainSplitterLeft;
     void setupUI();
     void clearLayout(QLayout* layout);
     void setupMenu();
-    QWidget* createCellWidget(const CellInfo& cellInfo, int colIndex, int cellIndex, const QList<int>& parentPath = QList<int>());
-    QWidget* createSubCellWidget(const CellInfo& cellInfo, int colIndex, int subCellIndex, const QList<int>& parentPath);
+    QWidget* createCellWidget(const CellInfo& cellInfo, int colIndex, int cellIndex);
+    QWidget* createSubCellWidget(const CellInfo& cellInfo);
     void showCellInfo(const QString& pathDescription, const QString& cellName, const CellInfo& cellInfo);
     void updateRightPanel();  //  добавляем объявление метода
+    void appendHistory();     // дописать текущие значения всех ячеек в историю
+    void appendSamples(const QVector<SampleRecord>& samples);       // отсчеты из очереди приема
+    void scheduleUiUpdate();
+    int uiInterval() const;   // мс между перерисовками: кадр экрана, но не чаще "ui.maxRate"
+    void refreshCell(const CellInfo& cellInfo);  // обновить виджеты одной ячейки
+
+    // Виджеты значения ячейки, запомненные при построении (без findChild при обновлении)
+    struct CellWidgets {
+        QLabel *valueLabel = nullptr;
+        TemperatureGauge *gauge = nullptr;
+        PlotWidget *sparkline = nullptr;
+    };
+    QVector<CellWidgets> cellWidgets;   // номер канала -> виджеты
+    QVector<CellRef> channelRefs;       // номер канала -> положение в текущей разметке
+    void setCellWidgets(int channel, const CellWidgets& handles);
+    CellRef channelRef(int channel) const;
+
+    // Сверка раскладки с конфигом: колонки по номеру, ячейки по каналу
+    struct ColumnWidgets {
+        QFrame *frame = nullptr;
+        QLabel *title = nullptr;
+        QVBoxLayout *layout = nullptr;
+    };
+    struct PooledCell {
+        QWidget *widget = nullptr;
+        QString shape;          // вид ячейки, при котором виджет можно переиспользовать
+        QVector<int> subChannels;
+    };
+    QList<ColumnWidgets> columnWidgets;
+    QVector<PooledCell> cellPool;     // канал основной ячейки -> ее виджет
+    QList<QWidget*> duplicateCells;   // ячейки с повторным id (не переиспользуются)
+    int selectedChannel = -1;         // выбранная ячейка (переживает смену раскладки)
+
+    QFrame* createColumnFrame(ColumnWidgets& column);
+    void reconcileLayout(const QList<ColumnConfig>& columns);
 
 GraphWidget *graphWidget;
+    PlotWidget *overlayPlot = nullptr;
+    DashboardModel *dashboardModel = nullptr;
+    QTreeView *dashboardView = nullptr;
+    bool compactView = false;
     // === UI Элементы ===
     QPushButton *configButton;
     QScrollArea *scrollArea;
@@ -54,14 +109,43 @@ GraphWidget *graphWidget;
     QHBoxLayout *mainLayout;
     QVBoxLayout *rightPanel;  //  добавляем панель справа
     QTextEdit *cellInfoDisplay;
+    HistoryModel *historyModel = nullptr;   // история выбранного канала
+    QTableView *historyView = nullptr;
 
     // === Служебные ===
     ConfigManager *configManager;
     QVector<TemperatureGauge*> temperatureGauges;
-    QTimer *updateTimer;
+    QThread *ingestThread;
+    IngestWorker *ingestWorker;
 
     // === Хранилище истории ===
-    QMap<QString, QStringList> savedValues;
+    TimeSeriesStore historyStore;
+    HistoryArchive historyArchive;   // постоянная история на диске
+    int graphChannel = -1;           // канал, нарисованный на графике
+    quint64 historyGeneration = 0;   // последний снимок конфигурации, записанный в историю
+    quint64 workerGeneration = 0;    // номер последнего установленного снимка воркера
+    qint64 graphLastX = 0;           // время последней точки на графике
+    QVector<SampleRecord> sampleBuffer;   // переиспользуемый буфер для очереди отсчетов
+
+    // === Общий график ===
+    // Окно по x сдвигается скачками с запасом справа; пока оно не сменилось,
+    // каждый ряд дополняется в своем прореживателе только новыми записями
+    struct OverlaySeries {
+        M4Decimator decimator;
+        qint64 nextEntry = 0;   // сквозной номер первой еще не добавленной записи
+        qint64 lastUntil = -1;  // конец последней добавленной записи
+    };
+    QList<OverlaySeries> overlaySeries;   // номер канала -> ряд
+    qint64 overlayFrom = 0;
+    qint64 overlayTo = -1;
+    int overlayWidth = 0;
+
+    // === Перерисовка по кадрам ===
+    QTimer *uiTimer = nullptr;
+    QElapsedTimer lastUiUpdate;
+    QVector<int> pendingChannels;    // каналы, изменившиеся с прошлой перерисовки
+    bool pendingLayout = false;
+
     QDockWidget *infoDock;
 signals:
     void cellClicked();
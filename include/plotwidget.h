@@ -0,0 +1,77 @@
+#ifndef PLOTWIDGET_H
+#define PLOTWIDGET_H
+
+#include <QWidget>
+#include <QVector>
+#include <QPointF>
+#include <QPolygonF>
+#include <QPixmap>
+#include <QColor>
+#include <QString>
+
+// Легкий график на QPainter для большого числа рядов и спарклайнов.
+// Ряды рисуются ломаными прямо из уже прореженных точек (x - мс с эпохи).
+// Фон, сетка и подписи осей кешируются в pixmap под размер и DPI и
+// перерисовываются только при смене размера или диапазона.
+// Изменение данных ряда перерисовывает только область от первой
+// изменившейся точки до правого края.
+class PlotWidget : public QWidget
+{
+    Q_OBJECT
+public:
+    enum Style {
+        Full,       // оси, сетка, подписи
+        Sparkline   // только линия, для ячеек
+    };
+
+    explicit PlotWidget(Style style = Full, QWidget *parent = nullptr);
+
+    int addSeries(const QString &name, const QColor &color = QColor());
+    int seriesCount() const { return series.size(); }
+    void clearSeries();
+
+    void setSeriesData(int index, const QVector<QPointF> &points);
+
+    // Видимый диапазон по x; по y - автомасштаб по всем рядам.
+    // Смена диапазона перерисовывает график целиком, поэтому для живых
+    // данных его лучше сдвигать скачками, а не на каждом кадре
+    void setXRange(double from, double to);
+    double xRangeFrom() const { return xFrom; }
+    double xRangeTo() const { return xTo; }
+
+    // Ширина области построения в пикселях - число интервалов прореживания
+    int plotWidth() const;
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void resizeEvent(QResizeEvent *event) override;
+
+private:
+    struct Series {
+        QString name;
+        QColor color;
+        QVector<QPointF> points;
+        QPolygonF polyline;     // точки в пикселях
+        double minY = 0;
+        double maxY = 0;
+        bool mapped = false;
+    };
+
+    QRectF plotRect() const;
+    void updateYRange();
+    void mapSeries(Series &s) const;
+    void invalidateAll();
+    void rebuildGrid();
+
+    Style style;
+    QVector<Series> series;
+    double xFrom = 0, xTo = 1;
+    double yMin = 0, yMax = 1;
+
+    QPixmap gridCache;
+    bool gridDirty = true;
+};
+
+#endif // PLOTWIDGET_H
@@ -0,0 +1,87 @@
+#ifndef SAMPLEQUEUE_H
+#define SAMPLEQUEUE_H
+
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+
+// Компактный отсчет канала для передачи между потоками
+struct SampleRecord {
+    int channel;
+    qint64 timestamp;   // мс с эпохи
+    double value;
+};
+
+// Очередь отсчетов без блокировок: один производитель (поток приема)
+// и один потребитель (GUI / история). Емкость фиксирована и округляется
+// до степени двойки; push и pop - несколько атомарных операций, без
+// мьютексов и без сигналов Qt на каждый отсчет.
+//
+// Политика при переполнении выбирается производителем:
+//   DropOldest - новый отсчет вытесняет самый старый непрочитанный;
+//   DropNewest - новый отсчет отбрасывается;
+//   Coalesce   - отсчеты, не поместившиеся в очередь, копятся на стороне
+//                производителя по одному на канал (более новый заменяет
+//                старый) и дописываются, как только освободится место.
+// Все потерянные отсчеты считаются в droppedCount().
+class SampleQueue
+{
+public:
+    enum OverflowPolicy {
+        DropOldest,
+        DropNewest,
+        Coalesce
+    };
+
+    static constexpr int DefaultCapacity = 65536;
+
+    explicit SampleQueue(int capacity = DefaultCapacity);
+
+    // "dropOldest", "dropNewest", "coalesce"; иначе fallback
+    static OverflowPolicy policyFromString(const QString& name, OverflowPolicy fallback = DropOldest);
+
+    // --- Поток производителя ---
+    void setPolicy(OverflowPolicy policy) { overflow = policy; }
+    OverflowPolicy policy() const { return overflow; }
+    void push(const SampleRecord& sample);
+    // Дописать накопленные при Coalesce отсчеты, если место уже освободилось
+    void flush();
+
+    // --- Поток потребителя ---
+    // Забрать до max самых старых отсчетов; возвращает их число
+    int pop(SampleRecord* out, int max);
+
+    // --- Любой поток ---
+    int capacity() const { return int(mask + 1); }
+    quint64 droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Поля слота атомарные: при DropOldest производитель может переписывать
+    // слот, который потребитель в этот момент читает. Такое чтение потребитель
+    // отбрасывает (его CAS по head не пройдет), но сама гонка не должна быть UB
+    struct Slot {
+        std::atomic<int> channel{0};
+        std::atomic<qint64> timestamp{0};
+        std::atomic<quint64> valueBits{0};
+    };
+
+    bool tryPush(const SampleRecord& sample);
+    void write(quint64 position, const SampleRecord& sample);
+
+    std::unique_ptr<Slot[]> slots;
+    quint64 mask;
+
+    // Счетчики позиций только растут; индекс слота - позиция & mask.
+    // head двигает потребитель, а при DropOldest - и производитель (CAS)
+    alignas(64) std::atomic<quint64> head{0};
+    alignas(64) std::atomic<quint64> tail{0};
+    alignas(64) std::atomic<quint64> dropped{0};
+
+    // Состояние производителя
+    OverflowPolicy overflow = DropOldest;
+    QHash<int, SampleRecord> coalesced;   // канал -> последний не поместившийся отсчет
+};
+
+#endif // SAMPLEQUEUE_H
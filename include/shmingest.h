@@ -0,0 +1,52 @@
+#ifndef SHMINGEST_H
+#define SHMINGEST_H
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QElapsedTimer>
+#include <atomic>
+#include "samplequeue.h"
+
+// Чтение разделяемого кольца ShmRing на стороне HUI. Файл отображается
+// только для чтения; poll() проходит по счетчикам каналов и забирает
+// новые отсчеты прямо из отображения. Номера каналов HUI выдаются по id
+// из заголовков каналов (реестр Channels), один раз на канал кольца.
+// Если писатель еще не запущен или закрыл кольцо, poll() раз в секунду
+// пытается открыть файл заново.
+class ShmIngest
+{
+public:
+    ShmIngest() = default;
+    ~ShmIngest() { close(); }
+
+    void setPath(const QString& path);
+    QString path() const { return filePath; }
+    bool isOpen() const { return base != nullptr; }
+
+    // Дописать в out новые отсчеты; отсчеты одного канала идут подряд и по времени
+    void poll(QVector<SampleRecord>& out);
+
+    // Отсчеты, перезаписанные писателем до того, как их успели прочитать.
+    // Можно читать из любого потока
+    quint64 droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    struct Channel {
+        int channel = -1;        // номер канала HUI; -1 - у канала кольца еще нет id
+        quint64 next = 0;        // номер следующего непрочитанного отсчета
+    };
+
+    bool open();
+    void close();
+
+    QString filePath;
+    QFile file;
+    uchar *base = nullptr;
+    quint32 slotCount = 0;
+    QVector<Channel> channels;
+    QElapsedTimer lastAttempt;
+    std::atomic<quint64> dropped{0};
+};
+
+#endif // SHMINGEST_H
@@ -0,0 +1,86 @@
+#ifndef SHMRING_H
+#define SHMRING_H
+
+#include <QtGlobal>
+#include <atomic>
+#include <cstring>
+
+// Разделяемое кольцо отсчетов для процессов сбора на той же машине.
+// Файл в разделяемой памяти (например, /dev/shm/hui.ring) отображается
+// в память писателем и HUI; данные читаются прямо из отображения, без
+// системных вызовов на каждую пачку.
+//
+// Раскладка файла:
+//   Header                             - 64 байта
+//   ChannelHeader x channelCount       - id ячейки и счетчик записанных отсчетов
+//   Slot x slotCount x channelCount    - кольца каналов подряд
+//
+// У каждого канала один писатель. Слот защищен seqlock: пока пишется
+// отсчет номер i, seq = 2*i + 1, после записи seq = 2*i + 2. Читатель
+// принимает слот, только если seq до и после чтения равен 2*i + 2,
+// иначе отсчет уже перезаписан следующим кругом кольца и считается потерянным.
+namespace ShmRing {
+    const quint32 Magic = 0x53495548;   // "HUIS"; 0 - писатель закрыл кольцо
+    const quint32 Version = 1;
+    const int IdSize = 64;
+
+    struct Header {
+        std::atomic<quint32> magic;
+        quint32 version;
+        quint32 channelCount;
+        quint32 slotCount;      // слотов на канал, степень двойки
+        char reserved[48];
+    };
+
+    struct ChannelHeader {
+        char id[IdSize];                    // id ячейки в UTF-8, с нулем в конце
+        std::atomic<quint64> written;       // отсчетов записано за все время
+        char reserved[56];                  // до 128 байт: счетчики каналов в разных кеш-линиях
+    };
+
+    struct Slot {
+        std::atomic<quint64> seq;
+        std::atomic<qint64> timestamp;      // мс с эпохи
+        std::atomic<quint64> valueBits;     // double побитно
+    };
+
+    // Атомарные операции должны работать между процессами - только без блокировок
+    static_assert(std::atomic<quint64>::is_always_lock_free, "нужны 64-битные атомарные операции без блокировок");
+    static_assert(sizeof(Header) == 64 && sizeof(ChannelHeader) == 128, "раскладка файла");
+
+    inline qint64 fileSize(quint32 channelCount, quint32 slotCount)
+    {
+        return qint64(sizeof(Header)) + qint64(channelCount) * qint64(sizeof(ChannelHeader))
+             + qint64(channelCount) * qint64(slotCount) * qint64(sizeof(Slot));
+    }
+
+    inline ChannelHeader* channel(uchar* base, quint32 ch)
+    {
+        return reinterpret_cast<ChannelHeader*>(base + sizeof(Header)) + ch;
+    }
+
+    inline Slot* slots(uchar* base, quint32 ch)
+    {
+        const Header* header = reinterpret_cast<const Header*>(base);
+        Slot* first = reinterpret_cast<Slot*>(base + sizeof(Header) + header->channelCount * sizeof(ChannelHeader));
+        return first + qint64(ch) * header->slotCount;
+    }
+
+    // Запись одного отсчета (только писатель канала)
+    inline void write(ChannelHeader* channel, Slot* ring, quint32 slotCount, qint64 timestamp, double value)
+    {
+        quint64 i = channel->written.load(std::memory_order_relaxed);
+        Slot& slot = ring[i & (slotCount - 1)];
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+
+        slot.seq.store(2 * i + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.timestamp.store(timestamp, std::memory_order_relaxed);
+        slot.valueBits.store(bits, std::memory_order_relaxed);
+        slot.seq.store(2 * i + 2, std::memory_order_release);
+        channel->written.store(i + 1, std::memory_order_release);
+    }
+}
+
+#endif // SHMRING_H
@@ -2,78 +2,141 @@
 #include <QColor>
 #include <QFont>
 #include <QPainter>
+#include <QPixmap>
+#include <QVector>
 #include <QWidget>
 #include <QtMath>
 
+// Цветной сегмент шкалы в единицах значения
+struct GaugeSegment {
+  double from;
+  double to;
+  QColor color;
+};
+
+// Стрелочный индикатор. Статичный циферблат (фон и цветные сегменты)
+// рисуется один раз в pixmap под текущий размер и DPI; на каждом
+// обновлении поверх него рисуются только стрелка и подпись.
 class TemperatureGauge : public QWidget {
   Q_OBJECT
 public:
   explicit TemperatureGauge(QWidget *parent = nullptr)
-      : QWidget(parent), temperature(0) {
+      : QWidget(parent), temperature(0), minValue(0), maxValue(120),
+        segments(defaultSegments()), labelFont("Arial", 16, QFont::Bold) {
     setMinimumSize(120, 120);
   }
 
-  void setTemperature(int temp) {
-    temperature = qBound(0, temp, 120); // ограничиваем до 0-120
+  // Стандартная шкала 0-120 из пяти сегментов
+  static QVector<GaugeSegment> defaultSegments() {
+    return {
+        {0, 20, QColor(0, 0, 255)},    // синий
+        {20, 40, QColor(0, 255, 0)},   // зеленый
+        {40, 60, QColor(255, 255, 0)}, // желтый
+        {60, 90, QColor(255, 0, 0)},   // красный
+        {90, 120, QColor(0, 0, 0)}     // черный
+    };
+  }
+
+  // Диапазон и сегменты шкалы (пустой список - без цветных сегментов)
+  void setScale(double min, double max, const QVector<GaugeSegment> &segs) {
+    if (max <= min) return;
+    minValue = min;
+    maxValue = max;
+    segments = segs;
+    temperature = qBound(minValue, temperature, maxValue);
+    dialDirty = true;
+    update();
+  }
+
+  void setTemperature(double temp) {
+    temp = qBound(minValue, temp, maxValue);
+    if (temp == temperature) return; // значение не изменилось - не перерисовываем
+    temperature = temp;
     update();
   }
 
 protected:
   void paintEvent(QPaintEvent *) override {
+    if (dialDirty || dialCache.size() != size() * devicePixelRatioF()) {
+      renderDial();
+    }
+
     QPainter p(this);
+    p.drawPixmap(0, 0, dialCache);
     p.setRenderHint(QPainter::Antialiasing);
+    applyTransform(p);
 
+    // стрелка
+    double needleAngle = StartAngle - fraction(temperature) * AngleSpan;
+    p.save();
+    p.rotate(-needleAngle + 90); // поворот относительно вертикали вверх
+    QPoint needle[3] = {QPoint(-3, 0), QPoint(0, -60), QPoint(3, 0)};
+    p.setBrush(Qt::black);
+    p.setPen(Qt::NoPen);
+    p.drawPolygon(needle, 3);
+    p.restore();
+
+    // текст температуры
+    p.setPen(Qt::black);
+    p.setFont(labelFont);
+    p.drawText(-25, 50, QString::number(qRound(temperature)) + "°C");
+  }
+
+  void resizeEvent(QResizeEvent *event) override {
+    QWidget::resizeEvent(event);
+    dialDirty = true;
+  }
+
+private:
+  static constexpr double StartAngle = 225.0; // где начинается минимум шкалы
+  static constexpr double AngleSpan = 270.0;  // полная ширина шкалы
+
+  double fraction(double value) const {
+    return (value - minValue) / (maxValue - minValue);
+  }
+
+  // Координаты циферблата: центр в середине, сторона 200 единиц
+  void applyTransform(QPainter &p) const {
     int side = qMin(width(), height());
     p.translate(width() / 2, height() / 2);
     p.scale(side / 200.0, side / 200.0);
+  }
+
+  void renderDial() {
+    qreal dpr = devicePixelRatioF();
+    dialCache = QPixmap(size() * dpr);
+    dialCache.setDevicePixelRatio(dpr);
+    dialCache.fill(Qt::transparent);
+
+    QPainter p(&dialCache);
+    p.setRenderHint(QPainter::Antialiasing);
+    applyTransform(p);
 
     // фон
     p.setBrush(QColor(200, 200, 200)); // серый фон
     p.setPen(Qt::NoPen);
     p.drawEllipse(-90, -90, 180, 180);
 
-    double startAngle = 225.0; // где начинается 0
-    double angleSpan = 270.0;  // полная ширина шкалы
-
-
-    double needleAngle = startAngle - (temperature / 120.0) * angleSpan;
     // сегменты шкалы
-    struct Segment {
-      double from;
-      double to;
-      QColor color;
-    };
-    Segment segments[] = {
-        {0, 20, QColor(0, 0, 255)},    // синий
-        {20, 40, QColor(0, 255, 0)},   // зеленый
-        {40, 60, QColor(255, 255, 0)}, // желтый
-        {60, 90, QColor(255, 0, 0)},   // красный
-        {90, 120, QColor(0, 0, 0)}     // черный
-    };
-
-    for (const Segment &seg : segments) {
-      double segStartAngle = startAngle - (seg.from / 120.0) * angleSpan;
-      double segSpan = (seg.to - seg.from) / 120.0 * angleSpan;
+    for (const GaugeSegment &seg : segments) {
+      double from = qBound(minValue, seg.from, maxValue);
+      double to = qBound(minValue, seg.to, maxValue);
+      double segStartAngle = StartAngle - fraction(from) * AngleSpan;
+      double segSpan = (to - from) / (maxValue - minValue) * AngleSpan;
 
       p.setPen(QPen(seg.color, 8, Qt::SolidLine, Qt::FlatCap));
       p.drawArc(-70, -70, 140, 140, segStartAngle * 16, -segSpan * 16);
     }
 
-    // стрелка
-    p.save();
-    p.rotate(-needleAngle + 90 ); // поворот относительно вертикали вверх
-    QPoint needle[3] = {QPoint(-3, 0), QPoint(0, -60), QPoint(3, 0)};
-    p.setBrush(Qt::black);
-    p.setPen(Qt::NoPen);
-    p.drawPolygon(needle, 3);
-    p.restore();
-
-    // текст температуры
-    p.setPen(Qt::black);
-    p.setFont(QFont("Arial", 16, QFont::Bold));
-    p.drawText(-25, 50, QString::number(temperature) + "°C");
+    dialDirty = false;
   }
 
-private:
-  int temperature;
+  double temperature;
+  double minValue;
+  double maxValue;
+  QVector<GaugeSegment> segments;
+  QFont labelFont;
+
+  QPixmap dialCache;
+  bool dialDirty = true;
 };
@@ -0,0 +1,194 @@
+#ifndef TIMESERIESSTORE_H
+#define TIMESERIESSTORE_H
+
+#include <QString>
+#include <QVector>
+#include <QtGlobal>
+#include "cellvalue.h"
+#include "gorillachunk.h"
+
+// Отсчет истории со сжатием повторов (RLE): значение value держалось
+// с момента timestamp до until включительно (мс с эпохи).
+// Плато из одинаковых значений занимает одну запись.
+struct Sample {
+    qint64 timestamp;
+    qint64 until;
+    double value;
+};
+
+// Агрегат отсчетов за интервал [start, start + разрешение уровня)
+struct Rollup {
+    qint64 start;
+    double min;
+    double max;
+    double sum;
+    int count;
+
+    double mean() const { return count > 0 ? sum / count : 0.0; }
+};
+
+// Кольцевой буфер фиксированной емкости.
+// Память растет до capacity и дальше не меняется: новые элементы
+// вытесняют самые старые, добавление O(1).
+template <typename T>
+class FixedRing
+{
+public:
+    explicit FixedRing(int capacity = 0) : head(0), count(0), maxSize(qMax(1, capacity)) {}
+
+    void setCapacity(int capacity); // при уменьшении сохраняются самые новые
+    int capacity() const { return maxSize; }
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    void append(const T& item);
+    void clear() { buffer.clear(); head = 0; count = 0; }
+
+    // 0 - самый старый элемент
+    const T& at(int index) const { return buffer[(head + index) % buffer.size()]; }
+    const T& last() const { return at(count - 1); }
+    T& last() { return buffer[(head + count - 1) % buffer.size()]; }
+
+    qint64 memoryUsage() const { return qint64(buffer.capacity()) * qint64(sizeof(T)); }
+
+private:
+    QVector<T> buffer;
+    int head;       // индекс самого старого элемента
+    int count;
+    int maxSize;
+};
+
+template <typename T>
+void FixedRing<T>::setCapacity(int capacity)
+{
+    capacity = qMax(1, capacity);
+    if (capacity == maxSize) return;
+
+    // Перекладываем самые новые элементы в начало нового буфера
+    int keep = qMin(count, capacity);
+    QVector<T> resized;
+    resized.reserve(keep);
+    for (int i = count - keep; i < count; ++i) {
+        resized.append(at(i));
+    }
+
+    buffer = resized;
+    head = 0;
+    count = keep;
+    maxSize = capacity;
+}
+
+template <typename T>
+void FixedRing<T>::append(const T& item)
+{
+    if (buffer.size() < maxSize) {
+        // Буфер еще не заполнен: растем до емкости, head остается 0
+        buffer.append(item);
+        ++count;
+        return;
+    }
+
+    // Заполнен: перезаписываем самый старый элемент
+    buffer[head] = item;
+    head = (head + 1) % maxSize;
+}
+
+using SampleRing = FixedRing<Sample>;
+using RollupRing = FixedRing<Rollup>;
+
+// Хранилище временных рядов: по кольцевому буферу на канал.
+// Канал адресуется номером из реестра Channels (по стабильному id ячейки),
+// каналы лежат в плотном массиве по этому номеру, поэтому горячий путь
+// обходится без поиска по строковым ключам.
+//
+// Отсчеты, вытесненные из кольца, не теряются, а дописываются в сжатые
+// блоки (GorillaChunk); закрытые блоки хранятся в своем кольце, поэтому
+// сырая история в памяти намного длиннее емкости кольца.
+//
+// Кроме сырых отсчетов для каждого канала на лету ведутся агрегаты
+// min/max/mean/count за 1 с, 1 мин и 1 ч. Каждый новый отсчет обновляет
+// последний агрегат каждого уровня за O(1), поэтому просмотр суток
+// стоит столько же, сколько просмотр последней минуты. Повтор значения
+// (продление плато) в count и mean не входит.
+class TimeSeriesStore
+{
+public:
+    static constexpr int DefaultCapacity = 3600; // час при обновлении раз в секунду
+    static constexpr int ChunkSamples = 512;     // отсчетов в сжатом блоке
+    static constexpr int DefaultSealedChunks = 64;
+
+    // Уровни разрешения истории
+    enum Tier {
+        Raw = 0,
+        Second,
+        Minute,
+        Hour,
+        TierCount
+    };
+    static qint64 tierResolution(int tier);   // мс на агрегат, 0 для Raw
+    static int tierCapacity(int tier);        // агрегатов в кольце уровня
+    // Самый грубый уровень, у которого на пиксель приходится не больше одного агрегата
+    static int tierFor(qint64 msPerPixel);
+
+    TimeSeriesStore();
+
+    // Создать канал с номером ch (если его еще нет); key - id ячейки для подписей.
+    // Массив каналов растет до ch, номера без ячеек с историей остаются пустыми
+    void ensureChannel(int ch, const QString& key);
+    bool hasChannel(int ch) const { return ch >= 0 && ch < channels.size() && !channels[ch].key.isEmpty(); }
+    int channelCount() const { return channels.size(); }
+    QString channelKey(int ch) const { return channels[ch].key; }
+
+    // Емкость по умолчанию для новых каналов и каналов без явной емкости
+    void setDefaultCapacity(int samples);
+    int defaultCapacity() const { return defaultSize; }
+    // Явная емкость канала; 0 - использовать емкость по умолчанию
+    void setCapacity(int ch, int samples);
+    // Сколько закрытых сжатых блоков хранить на канал
+    void setSealedChunks(int chunks);
+
+    // Оформление значений канала для отображения
+    void setFormat(int ch, CellValue::Kind kind, const QString& unit);
+    QString formatValue(int ch, double value) const;
+
+    // Повтор последнего значения только продлевает его запись
+    void append(int ch, qint64 timestamp, double value);
+    const SampleRing& samples(int ch) const { return channels[ch].ring; }
+    const RollupRing& rollups(int ch, int tier) const { return channels[ch].rollups[tier - 1]; }
+    // Сжатая часть сырой истории, старше кольца: закрытые блоки, затем открытый
+    const FixedRing<GorillaChunk>& sealedChunks(int ch) const { return channels[ch].sealed; }
+    const GorillaChunk& openChunk(int ch) const { return channels[ch].open; }
+    // Время самого старого отсчета уровня в памяти; -1, если уровень пуст
+    qint64 tierStart(int ch, int tier) const;
+
+    // Сквозная нумерация сырых записей канала (сжатые блоки, затем кольцо):
+    // firstEntry - номер самой старой записи в памяти (растет, когда вытесняется
+    // закрытый блок), entryCount - сколько записей сейчас хранится
+    qint64 firstEntry(int ch) const { return channels[ch].dropped; }
+    qint64 entryCount(int ch) const { return channels[ch].appended - channels[ch].dropped; }
+
+    qint64 memoryUsage() const;
+
+private:
+    struct Channel {
+        QString key;            // пустой - номер не занят
+        SampleRing ring;
+        RollupRing rollups[TierCount - 1];   // Second, Minute, Hour
+        FixedRing<GorillaChunk> sealed;
+        GorillaChunk open;
+        int explicitCapacity = 0;
+        qint64 appended = 0;    // записей добавлено за все время
+        qint64 dropped = 0;     // из них потеряно с вытесненными закрытыми блоками
+        CellValue::Kind kind = CellValue::Number;
+        QString unit;
+    };
+
+    void resizeRing(Channel& channel, int capacity);
+    void compress(Channel& channel, const Sample& sample);
+
+    QVector<Channel> channels;
+    int defaultSize;
+    int sealedLimit;   // закрытых блоков на канал
+};
+
+#endif // TIMESERIESSTORE_H
@@ -0,0 +1,106 @@
+#include "cellvalue.h"
+#include <QHash>
+#include <QStringList>
+#include <QMutex>
+#include <QMutexLocker>
+
+QString CellValue::toString() const
+{
+    switch (kind) {
+    case Number:
+        return QString::number(number, 'f', 2); // 2 знака после запятой
+    case Duration: {
+        qint64 total = qint64(number);
+        return QString("%1:%2:%3")
+            .arg(total / 3600)
+            .arg((total / 60) % 60, 2, 10, QChar('0'))
+            .arg(total % 60, 2, 10, QChar('0'));
+    }
+    case Text:
+        return text;
+    case Empty:
+        break;
+    }
+    return QString();
+}
+
+CellValue CellValue::fromNumber(double value)
+{
+    CellValue v;
+    v.kind = Number;
+    v.number = value;
+    return v;
+}
+
+CellValue CellValue::fromString(const QString& value)
+{
+    CellValue v;
+    QString trimmed = value.trimmed();
+    if (trimmed.isEmpty()) {
+        return v;
+    }
+    v.text = value;
+
+    bool ok = false;
+    double number = trimmed.toDouble(&ok);
+    if (!ok && trimmed.contains(',')) {
+        // десятичный разделитель запятой
+        number = QString(trimmed).replace(',', '.').toDouble(&ok);
+    }
+    if (ok) {
+        v.kind = Number;
+        v.number = number;
+        return v;
+    }
+
+    // Длительность "ч:м:с" или "ч:м"
+    const QStringList parts = trimmed.split(':');
+    if (parts.size() == 2 || parts.size() == 3) {
+        qint64 seconds = 0;
+        bool allOk = true;
+        for (const QString& part : parts) {
+            qint64 n = part.toLongLong(&ok);
+            if (!ok || n < 0) {
+                allOk = false;
+                break;
+            }
+            seconds = seconds * 60 + n;
+        }
+        if (allOk) {
+            if (parts.size() == 2) seconds *= 60;
+            v.kind = Duration;
+            v.number = double(seconds);
+            return v;
+        }
+    }
+
+    v.kind = Text;
+    return v;
+}
+
+namespace {
+    QMutex g_unitsMutex;
+    QHash<QString, int> g_unitIds;
+    QStringList g_unitNames{QString()};
+}
+
+int Units::idFor(const QString& unit)
+{
+    if (unit.isEmpty()) return 0;
+
+    QMutexLocker locker(&g_unitsMutex);
+    auto it = g_unitIds.constFind(unit);
+    if (it != g_unitIds.constEnd()) {
+        return it.value();
+    }
+    int id = g_unitNames.size();
+    g_unitNames.append(unit);
+    g_unitIds.insert(unit, id);
+    return id;
+}
+
+QString Units::name(int id)
+{
+    QMutexLocker locker(&g_unitsMutex);
+    return id >= 0 && id < g_unitNames.size() ? g_unitNames[id] : QString();
+}
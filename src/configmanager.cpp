@@ -6,8 +6,404 @@
 #include <QJsonArray>
 #include <QDir>
 #include <QCoreApplication>
+#include <QRegularExpression>
+#include <QDateTime>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QtEndian>
+#include "jsonstreamreader.h"
 
-ConfigManager::ConfigManager(QObject *parent) : QObject(parent)
+// -------------------------------------------------------------
+// Потоковый разбор (JsonStreamReader) прямо в ColumnConfig/CellInfo
+// -------------------------------------------------------------
+namespace {
+    // Значение может быть числом или строкой (как в ConfigManager::valueFromJson)
+    bool readValue(JsonStreamReader& reader, CellValue& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::String) {
+            out = CellValue::fromString(reader.stringValue());
+        } else if (t == JsonStreamReader::Number) {
+            out = CellValue::fromNumber(reader.numberValue());
+        } else {
+            out = CellValue();
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        return true;
+    }
+
+    // "id": строка или целое число (число хранится своей записью, "42")
+    bool readId(JsonStreamReader& reader, QString& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::String) {
+            out = reader.stringValue();
+            return true;
+        }
+        if (t == JsonStreamReader::Number) {
+            out = QString::number(qint64(reader.numberValue()));
+            return true;
+        }
+        return reader.skipCurrent() && t != JsonStreamReader::End;
+    }
+
+    bool readString(JsonStreamReader& reader, QString& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::String) {
+            out = reader.stringValue();
+            return true;
+        }
+        return reader.skipCurrent() && t != JsonStreamReader::End;
+    }
+
+    bool readInt(JsonStreamReader& reader, int& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::Number) {
+            out = int(reader.numberValue());
+            return true;
+        }
+        return reader.skipCurrent() && t != JsonStreamReader::End;
+    }
+
+    bool readDouble(JsonStreamReader& reader, double& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::Number) {
+            out = reader.numberValue();
+            return true;
+        }
+        return reader.skipCurrent() && t != JsonStreamReader::End;
+    }
+
+    // "timestamp": время данных от производителя, мс с эпохи
+    bool readTimestamp(JsonStreamReader& reader, qint64& out)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t == JsonStreamReader::Number) {
+            out = qint64(reader.numberValue());
+            return true;
+        }
+        return reader.skipCurrent() && t != JsonStreamReader::End;
+    }
+
+    // "history": {"capacity": N}
+    bool readHistoryOptions(JsonStreamReader& reader, ConfigOptions& options)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t != JsonStreamReader::BeginObject) {
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("capacity")) {
+                ok = readInt(reader, options.historyCapacity);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    // "ui": {"maxRate": N}
+    bool readUiOptions(JsonStreamReader& reader, ConfigOptions& options)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t != JsonStreamReader::BeginObject) {
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("maxRate")) {
+                ok = readInt(reader, options.uiMaxRate);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    // "ingest": {"overflow": "...", "socket": "...", "udpPort": N, "shm": "..."}
+    bool readIngestOptions(JsonStreamReader& reader, ConfigOptions& options)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t != JsonStreamReader::BeginObject) {
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("overflow")) {
+                ok = readString(reader, options.ingestOverflow);
+            } else if (reader.textEquals("socket")) {
+                ok = readString(reader, options.ingestSocket);
+            } else if (reader.textEquals("udpPort")) {
+                ok = readInt(reader, options.ingestUdpPort);
+            } else if (reader.textEquals("shm")) {
+                ok = readString(reader, options.ingestShm);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    // Текущий токен - BeginObject полосы шкалы
+    bool readGaugeBand(JsonStreamReader& reader, GaugeBand& band)
+    {
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("from")) {
+                ok = readDouble(reader, band.from);
+            } else if (reader.textEquals("to")) {
+                ok = readDouble(reader, band.to);
+            } else if (reader.textEquals("color")) {
+                ok = readString(reader, band.color);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    // "gauge": {"min": 0, "max": 120, "segments": [{"from", "to", "color"}, ...]}
+    bool readGauge(JsonStreamReader& reader, GaugeConfig& gauge)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t != JsonStreamReader::BeginObject) {
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok = true;
+            if (reader.textEquals("min")) {
+                ok = readDouble(reader, gauge.min);
+            } else if (reader.textEquals("max")) {
+                ok = readDouble(reader, gauge.max);
+            } else if (reader.textEquals("segments")) {
+                t = reader.next();
+                if (t != JsonStreamReader::BeginArray) {
+                    ok = reader.skipCurrent() && t != JsonStreamReader::End;
+                } else {
+                    while ((t = reader.next()) != JsonStreamReader::EndArray) {
+                        if (t == JsonStreamReader::BeginObject) {
+                            GaugeBand band;
+                            if (!readGaugeBand(reader, band)) return false;
+                            gauge.segments.append(band);
+                        } else if (t == JsonStreamReader::Invalid || t == JsonStreamReader::End || !reader.skipCurrent()) {
+                            return false;
+                        }
+                    }
+                }
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    // DOM-варианты для шкалы индикатора
+    QString idFromJson(const QJsonValue& val)
+    {
+        if (val.isDouble()) return QString::number(qint64(val.toDouble()));
+        return val.toString();
+    }
+
+    GaugeConfig gaugeFromJson(const QJsonObject& json)
+    {
+        GaugeConfig gauge;
+        gauge.min = json["min"].toDouble();
+        gauge.max = json["max"].toDouble();
+        const QJsonArray segments = json["segments"].toArray();
+        for (const QJsonValue& value : segments) {
+            QJsonObject obj = value.toObject();
+            GaugeBand band;
+            band.from = obj["from"].toDouble();
+            band.to = obj["to"].toDouble();
+            band.color = obj["color"].toString();
+            gauge.segments.append(band);
+        }
+        return gauge;
+    }
+
+    QJsonObject gaugeToJson(const GaugeConfig& gauge)
+    {
+        QJsonObject json;
+        json["min"] = gauge.min;
+        json["max"] = gauge.max;
+        QJsonArray segments;
+        for (const GaugeBand& band : gauge.segments) {
+            QJsonObject obj;
+            obj["from"] = band.from;
+            obj["to"] = band.to;
+            obj["color"] = band.color;
+            segments.append(obj);
+        }
+        if (!segments.isEmpty()) {
+            json["segments"] = segments;
+        }
+        return json;
+    }
+
+    bool readCell(JsonStreamReader& reader, CellInfo& cell, bool withSubCells);
+
+    bool readCellArray(JsonStreamReader& reader, QList<CellInfo>& cells, bool withSubCells)
+    {
+        JsonStreamReader::Token t = reader.next();
+        if (t != JsonStreamReader::BeginArray) {
+            return reader.skipCurrent() && t != JsonStreamReader::End;
+        }
+        for (;;) {
+            t = reader.next();
+            if (t == JsonStreamReader::EndArray) return true;
+            if (t == JsonStreamReader::BeginObject) {
+                CellInfo cell;
+                if (!readCell(reader, cell, withSubCells)) return false;
+                cells.append(cell);
+            } else if (t == JsonStreamReader::Invalid || t == JsonStreamReader::End || !reader.skipCurrent()) {
+                return false;
+            }
+        }
+    }
+
+    // Текущий токен - BeginObject ячейки. Подъячейки читаются только на
+    // первом уровне вложенности, как и в DOM-варианте.
+    bool readCell(JsonStreamReader& reader, CellInfo& cell, bool withSubCells)
+    {
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("id")) {
+                ok = readId(reader, cell.id);
+            } else if (reader.textEquals("content")) {
+                ok = readString(reader, cell.content);
+            } else if (reader.textEquals("value")) {
+                ok = readValue(reader, cell.value);
+            } else if (reader.textEquals("unit")) {
+                ok = readString(reader, cell.unit);
+            } else if (reader.textEquals("historyCapacity")) {
+                ok = readInt(reader, cell.historyCapacity);
+            } else if (reader.textEquals("gauge")) {
+                ok = readGauge(reader, cell.gauge);
+            } else if (withSubCells && reader.textEquals("subCells")) {
+                ok = readCellArray(reader, cell.subCells, false);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        cell.unitId = Units::idFor(cell.unit);
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    bool readColumn(JsonStreamReader& reader, ColumnConfig& column)
+    {
+        column.cellCount = 0;
+        while (reader.next() == JsonStreamReader::Key) {
+            bool ok;
+            if (reader.textEquals("name")) {
+                ok = readString(reader, column.name);
+            } else if (reader.textEquals("cellCount")) {
+                ok = readInt(reader, column.cellCount);
+            } else if (reader.textEquals("cells")) {
+                ok = readCellArray(reader, column.cells, true);
+            } else {
+                reader.next();
+                ok = reader.skipCurrent();
+            }
+            if (!ok) return false;
+        }
+        return reader.token() == JsonStreamReader::EndObject;
+    }
+
+    CellInfo* resolveCell(QList<ColumnConfig>& columns, const CellRef& r)
+    {
+        if (r.col < 0 || r.col >= columns.size()) return nullptr;
+        if (r.cell < 0 || r.cell >= columns[r.col].cells.size()) return nullptr;
+        CellInfo* target = &columns[r.col].cells[r.cell];
+        if (r.sub >= 0) {
+            if (r.sub >= target->subCells.size()) return nullptr;
+            target = &target->subCells[r.sub];
+        }
+        return target;
+    }
+
+    // Текущий токен - ключ (id ячейки); читает значение и записывает его по индексу
+    bool applyStreamValue(JsonStreamReader& reader, const CellIndex& index,
+                          QList<ColumnConfig>& columns, int& applied)
+    {
+        // Поиск до чтения значения: text() действителен только до следующего next()
+        QByteArrayView key = reader.text();
+        auto ref = index.constFind(QByteArray::fromRawData(key.data(), key.size()));
+        CellInfo* target = ref != index.constEnd() ? resolveCell(columns, ref.value()) : nullptr;
+
+        CellValue value;
+        if (!readValue(reader, value)) return false;
+        if (target) {
+            target->value = value;
+            ++applied;
+        }
+        return true;
+    }
+
+    // Текущий токен - BeginObject карты значений
+    int readValueMap(JsonStreamReader& reader, const CellIndex& index, QList<ColumnConfig>& columns)
+    {
+        int applied = 0;
+        while (reader.next() == JsonStreamReader::Key) {
+            if (!applyStreamValue(reader, index, columns, applied)) return -1;
+        }
+        return reader.token() == JsonStreamReader::EndObject ? applied : -1;
+    }
+
+    // Текущий токен - BeginArray списка изменений [{"id": ..., "value": ...}, ...]
+    int readDeltaList(JsonStreamReader& reader, const CellIndex& index, QList<ColumnConfig>& columns)
+    {
+        int applied = 0;
+        JsonStreamReader::Token t;
+        while ((t = reader.next()) == JsonStreamReader::BeginObject) {
+            QString id;
+            CellValue value;
+            bool hasValue = false;
+            while (reader.next() == JsonStreamReader::Key) {
+                bool ok;
+                if (reader.textEquals("id")) {
+                    ok = readId(reader, id);
+                } else if (reader.textEquals("value")) {
+                    ok = readValue(reader, value);
+                    hasValue = true;
+                } else {
+                    reader.next();
+                    ok = reader.skipCurrent();
+                }
+                if (!ok) return -1;
+            }
+            if (reader.token() != JsonStreamReader::EndObject) return -1;
+            if (id.isEmpty() || !hasValue) continue;
+
+            auto ref = index.constFind(id.toUtf8());
+            CellInfo* target = ref != index.constEnd() ? resolveCell(columns, ref.value()) : nullptr;
+            if (target) {
+                target->value = value;
+                ++applied;
+            }
+        }
+        return t == JsonStreamReader::EndArray ? applied : -1;
+    }
+}
+
+ConfigManager::ConfigManager(QObject *parent)
+    : QObject(parent)
+    , current(std::make_shared<ConfigSnapshot>())
 {
     // Пытаемся найти конфиг в разных местах
     QStringList possiblePaths = {
@@ -48,6 +444,116 @@ bool ConfigManager::loadConfig(const QString& filename)
 
     qDebug() << "Содержимое файла" << filename << ":" << data;
 
+    return loadConfigData(data, filename);
+}
+
+bool ConfigManager::loadConfigData(const QByteArray& data, const QString& filename)
+{
+    auto next = std::make_shared<ConfigSnapshot>();
+    if (!parseConfig(data, filename, next->columns, &next->options)) {
+        return false;
+    }
+    next->sourcePath = filename;
+    next->timestamp = QDateTime::currentMSecsSinceEpoch();
+    install(next);
+    configPath = filename;
+
+    const QList<ColumnConfig>& columns = current->columns;
+    qDebug() << "Конфигурация загружена. Колонок:" << columns.size();
+    
+    // Отладочный вывод
+    for (int i = 0; i < columns.size(); ++i) {
+        qDebug() << "Колонка" << i << ":" << columns[i].name;
+        for (int j = 0; j < columns[i].cells.size(); ++j) {
+            qDebug() << "  Ячейка" << j << ":" << columns[i].cells[j].content 
+                     << "Значение:" << columns[i].cells[j].value.toString();
+            for (int k = 0; k < columns[i].cells[j].subCells.size(); ++k) {
+                qDebug() << "    Подъячейка" << k << ":" << columns[i].cells[j].subCells[k].content
+                         << "Значение:" << columns[i].cells[j].subCells[k].value.toString();
+            }
+        }
+    }
+    
+    return true;
+}
+
+bool ConfigManager::parseConfig(const QByteArray& data, const QString& filename, QList<ColumnConfig>& result,
+                                ConfigOptions* options, qint64* timestamp)
+{
+    JsonStreamReader reader(data);
+    if (reader.next() != JsonStreamReader::BeginObject) {
+        qWarning() << "Неверный JSON формат в файле:" << filename;
+        return false;
+    }
+
+    result.clear();
+    ConfigOptions parsedOptions;
+    qint64 parsedTimestamp = 0;
+    bool hasColumns = false;
+    while (reader.next() == JsonStreamReader::Key) {
+        if (reader.textEquals("history")) {
+            if (!readHistoryOptions(reader, parsedOptions)) break;
+            continue;
+        }
+        if (reader.textEquals("gauge")) {
+            if (!readGauge(reader, parsedOptions.gauge)) break;
+            continue;
+        }
+        if (reader.textEquals("ui")) {
+            if (!readUiOptions(reader, parsedOptions)) break;
+            continue;
+        }
+        if (reader.textEquals("ingest")) {
+            if (!readIngestOptions(reader, parsedOptions)) break;
+            continue;
+        }
+        if (reader.textEquals("timestamp")) {
+            if (!readTimestamp(reader, parsedTimestamp)) break;
+            continue;
+        }
+        if (!reader.textEquals("columns")) {
+            reader.next();
+            if (!reader.skipCurrent()) break;
+            continue;
+        }
+
+        if (reader.next() != JsonStreamReader::BeginArray) {
+            qWarning() << "Отсутствует или неверный массив columns в конфиге";
+            return false;
+        }
+        hasColumns = true;
+        for (;;) {
+            JsonStreamReader::Token t = reader.next();
+            if (t == JsonStreamReader::EndArray) break;
+            if (t == JsonStreamReader::BeginObject) {
+                ColumnConfig column;
+                if (!readColumn(reader, column)) break;
+                result.append(column);
+            } else if (t == JsonStreamReader::Invalid || t == JsonStreamReader::End || !reader.skipCurrent()) {
+                break;
+            }
+        }
+        if (reader.token() != JsonStreamReader::EndArray) break;
+    }
+
+    if (reader.token() != JsonStreamReader::EndObject || reader.next() != JsonStreamReader::End) {
+        qWarning() << "Неверный JSON формат в файле:" << filename;
+        return false;
+    }
+    if (!hasColumns) {
+        qWarning() << "Отсутствует или неверный массив columns в конфиге";
+        return false;
+    }
+
+    assignDefaultIds(result);
+    if (options) *options = parsedOptions;
+    if (timestamp) *timestamp = parsedTimestamp;
+    return true;
+}
+
+bool ConfigManager::parseConfigDom(const QByteArray& data, const QString& filename, QList<ColumnConfig>& result,
+                                   ConfigOptions* options, qint64* timestamp)
+{
     QJsonDocument doc = QJsonDocument::fromJson(data);
     if (doc.isNull()) {
         qWarning() << "Неверный JSON формат в файле:" << filename;
@@ -60,45 +566,368 @@ bool ConfigManager::loadConfig(const QString& filename)
         return false;
     }
 
-    columns.clear();
+    result.clear();
     QJsonArray columnsArray = root["columns"].toArray();
     for (const QJsonValue& value : columnsArray) {
         if (value.isObject()) {
-            ColumnConfig column = columnFromJson(value.toObject());
-            columns.append(column);
+            result.append(columnFromJson(value.toObject()));
         }
     }
+    assignDefaultIds(result);
 
-    configPath = filename;
-    qDebug() << "Конфигурация загружена. Колонок:" << columns.size();
-    
-    // Отладочный вывод
-    for (int i = 0; i < columns.size(); ++i) {
-        qDebug() << "Колонка" << i << ":" << columns[i].name;
-        for (int j = 0; j < columns[i].cells.size(); ++j) {
-            qDebug() << "  Ячейка" << j << ":" << columns[i].cells[j].content 
-                     << "Значение:" << columns[i].cells[j].value;
-            for (int k = 0; k < columns[i].cells[j].subCells.size(); ++k) {
-                qDebug() << "    Подъячейка" << k << ":" << columns[i].cells[j].subCells[k].content
-                         << "Значение:" << columns[i].cells[j].subCells[k].value;
+    if (options) {
+        *options = ConfigOptions();
+        options->historyCapacity = root["history"].toObject()["capacity"].toInt();
+        options->uiMaxRate = root["ui"].toObject()["maxRate"].toInt();
+        QJsonObject ingest = root["ingest"].toObject();
+        options->ingestOverflow = ingest["overflow"].toString();
+        options->ingestSocket = ingest["socket"].toString();
+        options->ingestUdpPort = ingest["udpPort"].toInt();
+        options->ingestShm = ingest["shm"].toString();
+        options->gauge = gaugeFromJson(root["gauge"].toObject());
+    }
+    if (timestamp) {
+        *timestamp = qint64(root["timestamp"].toDouble());
+    }
+    return true;
+}
+
+namespace {
+    bool sameCell(const CellInfo& a, const CellInfo& b)
+    {
+        return a.value == b.value && a.unit == b.unit;
+    }
+}
+
+bool ConfigManager::diffValues(const QList<ColumnConfig>& before, const QList<ColumnConfig>& after,
+                               QVector<int>& changedChannels)
+{
+    if (before.size() != after.size()) return false;
+    for (int col = 0; col < before.size(); ++col) {
+        const ColumnConfig& oldColumn = before[col];
+        const ColumnConfig& newColumn = after[col];
+        if (oldColumn.name != newColumn.name || oldColumn.cellCount != newColumn.cellCount
+            || oldColumn.cells.size() != newColumn.cells.size()) {
+            return false;
+        }
+        for (int cell = 0; cell < oldColumn.cells.size(); ++cell) {
+            const CellInfo& oldCell = oldColumn.cells[cell];
+            const CellInfo& newCell = newColumn.cells[cell];
+            if (oldCell.channel != newCell.channel || oldCell.content != newCell.content
+                || oldCell.subCells.size() != newCell.subCells.size()) {
+                return false;
+            }
+            if (!sameCell(oldCell, newCell)) {
+                changedChannels.append(newCell.channel);
+            }
+            for (int sub = 0; sub < oldCell.subCells.size(); ++sub) {
+                const CellInfo& oldSub = oldCell.subCells[sub];
+                const CellInfo& newSub = newCell.subCells[sub];
+                if (oldSub.channel != newSub.channel || oldSub.content != newSub.content) {
+                    return false;
+                }
+                if (!sameCell(oldSub, newSub)) {
+                    changedChannels.append(newSub.channel);
+                }
             }
         }
     }
-    
     return true;
 }
 
+// --------------------- Реестр каналов ---------------------
+namespace {
+    QMutex g_channelsMutex;
+    QHash<QString, int> g_channelIds;
+    QStringList g_channelKeys;
+}
+
+int Channels::idFor(const QString& cellId)
+{
+    QMutexLocker locker(&g_channelsMutex);
+    auto it = g_channelIds.constFind(cellId);
+    if (it != g_channelIds.constEnd()) {
+        return it.value();
+    }
+    int channel = g_channelKeys.size();
+    g_channelKeys.append(cellId);
+    g_channelIds.insert(cellId, channel);
+    return channel;
+}
+
+QString Channels::key(int channel)
+{
+    QMutexLocker locker(&g_channelsMutex);
+    return channel >= 0 && channel < g_channelKeys.size() ? g_channelKeys[channel] : QString();
+}
+
+int Channels::count()
+{
+    QMutexLocker locker(&g_channelsMutex);
+    return g_channelKeys.size();
+}
+
+QString ConfigManager::defaultCellId(int col, int cell, int sub)
+{
+    if (sub >= 0) {
+        return QString("%1/%2/%3").arg(col).arg(cell).arg(sub);
+    }
+    return QString("%1/%2").arg(col).arg(cell);
+}
+
+void ConfigManager::assignDefaultIds(QList<ColumnConfig>& columns)
+{
+    for (int col = 0; col < columns.size(); ++col) {
+        QList<CellInfo>& cells = columns[col].cells;
+        for (int cell = 0; cell < cells.size(); ++cell) {
+            if (cells[cell].id.isEmpty()) {
+                cells[cell].id = defaultCellId(col, cell);
+            }
+            cells[cell].channel = Channels::idFor(cells[cell].id);
+            QList<CellInfo>& subCells = cells[cell].subCells;
+            for (int sub = 0; sub < subCells.size(); ++sub) {
+                if (subCells[sub].id.isEmpty()) {
+                    subCells[sub].id = defaultCellId(col, cell, sub);
+                }
+                subCells[sub].channel = Channels::idFor(subCells[sub].id);
+            }
+        }
+    }
+}
+
+CellIndex ConfigManager::buildCellIndex(const QList<ColumnConfig>& columns)
+{
+    CellIndex index;
+    for (int col = 0; col < columns.size(); ++col) {
+        const QList<CellInfo>& cells = columns[col].cells;
+        for (int cell = 0; cell < cells.size(); ++cell) {
+            index.insert(cells[cell].id.toUtf8(), CellRef{col, cell, -1});
+            const QList<CellInfo>& subCells = cells[cell].subCells;
+            for (int sub = 0; sub < subCells.size(); ++sub) {
+                index.insert(subCells[sub].id.toUtf8(), CellRef{col, cell, sub});
+            }
+        }
+    }
+    return index;
+}
+
+QVector<CellRef> ConfigManager::buildChannelRefs(const QList<ColumnConfig>& columns)
+{
+    QVector<CellRef> refs(Channels::count());
+    auto place = [&refs](int channel, const CellRef& ref) {
+        if (channel < 0) return;
+        if (channel >= refs.size()) refs.resize(channel + 1);
+        refs[channel] = ref;
+    };
+    for (int col = 0; col < columns.size(); ++col) {
+        const QList<CellInfo>& cells = columns[col].cells;
+        for (int cell = 0; cell < cells.size(); ++cell) {
+            place(cells[cell].channel, CellRef{col, cell, -1});
+            const QList<CellInfo>& subCells = cells[cell].subCells;
+            for (int sub = 0; sub < subCells.size(); ++sub) {
+                place(subCells[sub].channel, CellRef{col, cell, sub});
+            }
+        }
+    }
+    return refs;
+}
+
+int ConfigManager::applyValues(const QByteArray& data, const CellIndex& index,
+                               QList<ColumnConfig>& columns, qint64* timestamp)
+{
+    JsonStreamReader reader(data);
+    JsonStreamReader::Token first = reader.next();
+    if (first == JsonStreamReader::BeginArray) {
+        int applied = readDeltaList(reader, index, columns);
+        if (applied >= 0 && reader.next() != JsonStreamReader::End) applied = -1;   // данные после корня
+        if (applied < 0) qWarning() << "Неверный список изменений значений";
+        return applied;
+    }
+    if (first != JsonStreamReader::BeginObject) {
+        qWarning() << "Неверный JSON формат в файле значений";
+        return -1;
+    }
+
+    // Допускается как {"values": {...}}, так и сразу плоский объект id -> значение;
+    // "delta" - список изменений, как и массив верхнего уровня
+    int applied = 0;
+    while (reader.next() == JsonStreamReader::Key) {
+        if (reader.textEquals("delta")) {
+            if (reader.next() == JsonStreamReader::BeginArray) {
+                int count = readDeltaList(reader, index, columns);
+                if (count < 0) break;
+                applied += count;
+            } else if (!reader.skipCurrent()) {
+                break;
+            }
+            continue;
+        }
+        if (reader.textEquals("values")) {
+            if (reader.next() == JsonStreamReader::BeginObject) {
+                int count = readValueMap(reader, index, columns);
+                if (count < 0) break;
+                applied += count;
+            } else if (!reader.skipCurrent()) {
+                break;
+            }
+            continue;
+        }
+        if (reader.textEquals("timestamp")) {
+            qint64 parsedTimestamp = 0;
+            if (!readTimestamp(reader, parsedTimestamp)) break;
+            if (timestamp) *timestamp = parsedTimestamp;
+            continue;
+        }
+        if (!applyStreamValue(reader, index, columns, applied)) break;
+    }
+
+    if (reader.token() != JsonStreamReader::EndObject || reader.next() != JsonStreamReader::End) {
+        qWarning() << "Неверный JSON формат в файле значений";
+        return -1;
+    }
+    return applied;
+}
+
+int ConfigManager::applyValuesDom(const QByteArray& data, const CellIndex& index,
+                                  QList<ColumnConfig>& columns, qint64* timestamp)
+{
+    QJsonDocument doc = QJsonDocument::fromJson(data);
+    if (!doc.isObject() && !doc.isArray()) {
+        qWarning() << "Неверный JSON формат в файле значений";
+        return -1;
+    }
+
+    int applied = 0;
+    auto apply = [&](const QString& id, const QJsonValue& value) {
+        auto ref = index.constFind(id.toUtf8());
+        if (ref == index.constEnd()) return;
+
+        CellInfo* target = resolveCell(columns, ref.value());
+        if (!target) return;
+        target->value = valueFromJson(value);
+        ++applied;
+    };
+    auto applyDelta = [&](const QJsonArray& delta) {
+        for (const QJsonValue& item : delta) {
+            QJsonObject change = item.toObject();
+            if (change.contains("value")) apply(idFromJson(change["id"]), change["value"]);
+        }
+    };
+
+    if (doc.isArray()) {
+        applyDelta(doc.array());
+        return applied;
+    }
+
+    QJsonObject root = doc.object();
+    QJsonObject values = root.contains("values") ? root["values"].toObject() : root;
+    if (timestamp && root.contains("timestamp")) {
+        *timestamp = qint64(root["timestamp"].toDouble());
+    }
+    for (auto it = values.constBegin(); it != values.constEnd(); ++it) {
+        apply(it.key(), it.value());
+    }
+    applyDelta(root["delta"].toArray());
+    return applied;
+}
+
+int ConfigManager::applyBinaryValues(const QByteArray& frame, const CellIndex& index,
+                                     QList<ColumnConfig>& columns, qint64* timestamp)
+{
+    const uchar* p = reinterpret_cast<const uchar*>(frame.constData());
+    const uchar* end = p + frame.size();
+    const int fixed = BinaryValuesHeader + 8 + 2;
+    if (frame.size() < fixed || qFromLittleEndian<quint32>(p) != BinaryValuesMagic
+        || qFromLittleEndian<quint32>(p + 4) != quint32(frame.size() - BinaryValuesHeader)) {
+        qWarning() << "Неверный двоичный кадр значений";
+        return -1;
+    }
+    qint64 parsedTimestamp = qFromLittleEndian<qint64>(p + BinaryValuesHeader);
+    int count = qFromLittleEndian<quint16>(p + BinaryValuesHeader + 8);
+    p += fixed;
+
+    int applied = 0;
+    for (int i = 0; i < count; ++i) {
+        if (end - p < 2) return -1;
+        int idLength = qFromLittleEndian<quint16>(p);
+        p += 2;
+        if (end - p < idLength + 8) return -1;
+        // Ключ без копирования - только для поиска в индексе
+        QByteArray id = QByteArray::fromRawData(reinterpret_cast<const char*>(p), idLength);
+        double number = qFromLittleEndian<double>(p + idLength);
+        p += idLength + 8;
+
+        auto ref = index.constFind(id);
+        if (ref == index.constEnd()) continue;
+        CellInfo* target = resolveCell(columns, ref.value());
+        if (!target) continue;
+        target->value = CellValue::fromNumber(number);
+        ++applied;
+    }
+    if (timestamp) *timestamp = parsedTimestamp;
+    return applied;
+}
+
+CellInfo* ConfigManager::cellAt(QList<ColumnConfig>& columns, const CellRef& ref)
+{
+    return resolveCell(columns, ref);
+}
+
+void ConfigManager::applySnapshot(const ConfigSnapshotPtr& snapshot)
+{
+    if (!snapshot) return;
+    install(snapshot);
+    configPath = snapshot->sourcePath;
+}
+
+std::shared_ptr<ConfigSnapshot> ConfigManager::editableCopy() const
+{
+    auto next = std::make_shared<ConfigSnapshot>(*current);
+    next->changedChannels.clear();
+    next->layoutChanged = false;
+    return next;
+}
+
+void ConfigManager::install(const ConfigSnapshotPtr& next)
+{
+    current = next;
+    ++currentGeneration;
+}
+
 bool ConfigManager::saveConfig(const QString& filename) const
 {
     QJsonObject root;
     QJsonArray columnsArray;
+    const ConfigOptions& options = current->options;
 
-    for (const ColumnConfig& column : columns) {
+    for (const ColumnConfig& column : current->columns) {
         columnsArray.append(columnToJson(column));
     }
 
     root["columns"] = columnsArray;
 
+    if (options.historyCapacity > 0) {
+        QJsonObject history;
+        history["capacity"] = options.historyCapacity;
+        root["history"] = history;
+    }
+    if (options.gauge.isValid()) {
+        root["gauge"] = gaugeToJson(options.gauge);
+    }
+    if (options.uiMaxRate > 0) {
+        QJsonObject ui;
+        ui["maxRate"] = options.uiMaxRate;
+        root["ui"] = ui;
+    }
+    QJsonObject ingest;
+    if (!options.ingestOverflow.isEmpty()) ingest["overflow"] = options.ingestOverflow;
+    if (!options.ingestSocket.isEmpty()) ingest["socket"] = options.ingestSocket;
+    if (options.ingestUdpPort > 0) ingest["udpPort"] = options.ingestUdpPort;
+    if (!options.ingestShm.isEmpty()) ingest["shm"] = options.ingestShm;
+    if (!ingest.isEmpty()) {
+        root["ingest"] = ingest;
+    }
+
     QJsonDocument doc(root);
     QFile file(filename);
     if (!file.open(QIODevice::WriteOnly)) {
@@ -116,7 +945,7 @@ bool ConfigManager::saveConfig(const QString& filename) const
 QStringList ConfigManager::getColumnNames() const
 {
     QStringList names;
-    for (const ColumnConfig& column : columns) {
+    for (const ColumnConfig& column : current->columns) {
         names.append(column.name);
     }
     return names;
@@ -125,7 +954,7 @@ QStringList ConfigManager::getColumnNames() const
 QList<int> ConfigManager::getCellCounts() const
 {
     QList<int> counts;
-    for (const ColumnConfig& column : columns) {
+    for (const ColumnConfig& column : current->columns) {
         counts.append(column.cellCount);
     }
     return counts;
@@ -133,9 +962,12 @@ QList<int> ConfigManager::getCellCounts() const
 
 bool ConfigManager::updateCellValue(int columnIndex, int cellIndex, const QString& value)
 {
+    const QList<ColumnConfig>& columns = current->columns;
     if (columnIndex >= 0 && columnIndex < columns.size() &&
         cellIndex >= 0 && cellIndex < columns[columnIndex].cells.size()) {
-        columns[columnIndex].cells[cellIndex].value = value;
+        auto next = editableCopy();
+        next->columns[columnIndex].cells[cellIndex].value = CellValue::fromString(value);
+        install(next);
         return true;
     }
     return false;
@@ -143,10 +975,13 @@ bool ConfigManager::updateCellValue(int columnIndex, int cellIndex, const QStrin
 
 bool ConfigManager::updateSubCellValue(int columnIndex, int cellIndex, int subCellIndex, const QString& value)
 {
+    const QList<ColumnConfig>& columns = current->columns;
     if (columnIndex >= 0 && columnIndex < columns.size() &&
         cellIndex >= 0 && cellIndex < columns[columnIndex].cells.size() &&
         subCellIndex >= 0 && subCellIndex < columns[columnIndex].cells[cellIndex].subCells.size()) {
-        columns[columnIndex].cells[cellIndex].subCells[subCellIndex].value = value;
+        auto next = editableCopy();
+        next->columns[columnIndex].cells[cellIndex].subCells[subCellIndex].value = CellValue::fromString(value);
+        install(next);
         return true;
     }
     return false;
@@ -154,30 +989,38 @@ bool ConfigManager::updateSubCellValue(int columnIndex, int cellIndex, int subCe
 
 QString ConfigManager::getCellValue(int columnIndex, int cellIndex) const
 {
+    const QList<ColumnConfig>& columns = current->columns;
     if (columnIndex >= 0 && columnIndex < columns.size() &&
         cellIndex >= 0 && cellIndex < columns[columnIndex].cells.size()) {
-        return columns[columnIndex].cells[cellIndex].value;
+        return columns[columnIndex].cells[cellIndex].value.toString();
     }
     return QString();
 }
 
 void ConfigManager::setColumns(const QList<ColumnConfig>& newColumns)
 {
-    columns = newColumns;
+    auto next = editableCopy();
+    next->columns = newColumns;
+    assignDefaultIds(next->columns);
+    install(next);
 }
 
 void ConfigManager::updateColumn(int index, const QString& name, int cellCount, const QList<CellInfo>& cellInfos)
 {
-    if (index >= 0 && index < columns.size()) {
-        columns[index].name = name;
-        columns[index].cellCount = cellCount;
-        columns[index].cells = cellInfos;
+    if (index >= 0 && index < current->columns.size()) {
+        auto next = editableCopy();
+        ColumnConfig& column = next->columns[index];
+        column.name = name;
+        column.cellCount = cellCount;
+        column.cells = cellInfos;
+        assignDefaultIds(next->columns);
+        install(next);
     }
 }
 
 void ConfigManager::createDefaultConfig()
 {
-    columns.clear();
+    QList<ColumnConfig> columns;
 
     ColumnConfig col1;
     col1.name = "ЦОС";
@@ -189,12 +1032,14 @@ void ConfigManager::createDefaultConfig()
         if (i == 0) {
             CellInfo subCell1;
             subCell1.content = "Подъячейка 1-1";
-            subCell1.value = "0.0 В";
+            subCell1.value = CellValue::fromNumber(0.0);
             subCell1.unit = "В";
+            subCell1.unitId = Units::idFor(subCell1.unit);
             CellInfo subCell2;
             subCell2.content = "Подъячейка 1-2";
-            subCell2.value = "0.0 В";
+            subCell2.value = CellValue::fromNumber(0.0);
             subCell2.unit = "В";
+            subCell2.unitId = Units::idFor(subCell2.unit);
             cell.subCells << subCell1 << subCell2;
         }
         col1.cells.append(cell);
@@ -204,17 +1049,26 @@ void ConfigManager::createDefaultConfig()
     col2.name = "ВИП";
     col2.cellCount = 5;
     for (int i = 0; i < col2.cellCount; ++i) {
-        col2.cells.append(CellInfo{QString("Содержимое %1-2").arg(i + 1)});
+        CellInfo cell;
+        cell.content = QString("Содержимое %1-2").arg(i + 1);
+        col2.cells.append(cell);
     }
 
     ColumnConfig col3;
     col3.name = "ПП";
     col3.cellCount = 2;
     for (int i = 0; i < col3.cellCount; ++i) {
-        col3.cells.append(CellInfo{QString("Содержимое %1-3").arg(i + 1)});
+        CellInfo cell;
+        cell.content = QString("Содержимое %1-3").arg(i + 1);
+        col3.cells.append(cell);
     }
 
     columns << col1 << col2 << col3;
+    assignDefaultIds(columns);
+
+    auto next = std::make_shared<ConfigSnapshot>();
+    next->columns = columns;
+    install(next);
 }
 
 ColumnConfig ConfigManager::columnFromJson(const QJsonObject& json)
@@ -252,24 +1106,25 @@ QJsonObject ConfigManager::columnToJson(const ColumnConfig& column) const
     return json;
 }
 
+CellValue ConfigManager::valueFromJson(const QJsonValue& val)
+{
+    // Значение может быть числом или строкой; разбирается один раз здесь
+    if (val.isString()) {
+        return CellValue::fromString(val.toString());
+    } else if (val.isDouble()) {
+        return CellValue::fromNumber(val.toDouble());
+    }
+    return CellValue();
+}
+
 CellInfo ConfigManager::cellFromJson(const QJsonObject& json)
 {
     CellInfo cell;
+    cell.id = idFromJson(json["id"]);
     cell.content = json["content"].toString();
 
     // Правильная загрузка значения value (число или строка)
-    if (json.contains("value")) {
-        QJsonValue val = json["value"];
-        if (val.isString()) {
-            cell.value = val.toString();
-        } else if (val.isDouble()) {
-            cell.value = QString::number(val.toDouble(), 'f', 2); // 2 знака после запятой
-        } else {
-            cell.value = "";
-        }
-    } else {
-        cell.value = "";
-    }
+    cell.value = valueFromJson(json["value"]);
 
     // Загрузка unit
     if (json.contains("unit")) {
@@ -277,8 +1132,11 @@ CellInfo ConfigManager::cellFromJson(const QJsonObject& json)
     } else {
         cell.unit = "";
     }
+    cell.unitId = Units::idFor(cell.unit);
+    cell.historyCapacity = json["historyCapacity"].toInt();
+    cell.gauge = gaugeFromJson(json["gauge"].toObject());
 
-    qDebug() << "Загружена ячейка:" << cell.content << "value:" << cell.value << "unit:" << cell.unit;
+    qDebug() << "Загружена ячейка:" << cell.content << "value:" << cell.value.toString() << "unit:" << cell.unit;
 
     // Загружаем подъячейки
     if (json.contains("subCells") && json["subCells"].isArray()) {
@@ -289,21 +1147,11 @@ CellInfo ConfigManager::cellFromJson(const QJsonObject& json)
             if (subCellValue.isObject()) {
                 QJsonObject subCellObj = subCellValue.toObject();
                 CellInfo subCell;
+                subCell.id = idFromJson(subCellObj["id"]);
                 subCell.content = subCellObj["content"].toString();
 
                 // Правильная загрузка value для подъячейки
-                if (subCellObj.contains("value")) {
-                    QJsonValue val = subCellObj["value"];
-                    if (val.isString()) {
-                        subCell.value = val.toString();
-                    } else if (val.isDouble()) {
-                        subCell.value = QString::number(val.toDouble(), 'f', 2);
-                    } else {
-                        subCell.value = "";
-                    }
-                } else {
-                    subCell.value = "";
-                }
+                subCell.value = valueFromJson(subCellObj["value"]);
 
                 // Загрузка unit
                 if (subCellObj.contains("unit")) {
@@ -311,8 +1159,10 @@ CellInfo ConfigManager::cellFromJson(const QJsonObject& json)
                 } else {
                     subCell.unit = "";
                 }
+                subCell.unitId = Units::idFor(subCell.unit);
+                subCell.historyCapacity = subCellObj["historyCapacity"].toInt();
 
-                qDebug() << "  Загружена подъячейка:" << subCell.content << "value:" << subCell.value << "unit:" << subCell.unit;
+                qDebug() << "  Загружена подъячейка:" << subCell.content << "value:" << subCell.value.toString() << "unit:" << subCell.unit;
                 cell.subCells.append(subCell);
             }
         }
@@ -324,16 +1174,32 @@ CellInfo ConfigManager::cellFromJson(const QJsonObject& json)
 QJsonObject ConfigManager::cellToJson(const CellInfo& cell) const
 {
     QJsonObject json;
+
+    // Пути по умолчанию не сохраняем - они пересчитываются при загрузке
+    static const QRegularExpression defaultIdPattern("^\\d+/\\d+(/\\d+)?$");
+    if (!cell.id.isEmpty() && !defaultIdPattern.match(cell.id).hasMatch()) {
+        json["id"] = cell.id;
+    }
     json["content"] = cell.content;
     
-    if (!cell.value.isEmpty()) {
-        json["value"] = cell.value;
+    // Строки сохраняем как были записаны, числа без исходного текста - числом
+    if (!cell.value.text.isEmpty()) {
+        json["value"] = cell.value.text;
+    } else if (cell.value.isNumeric()) {
+        json["value"] = cell.value.number;
     }
     
     if (!cell.unit.isEmpty()) {
         json["unit"] = cell.unit;
     }
 
+    if (cell.historyCapacity > 0) {
+        json["historyCapacity"] = cell.historyCapacity;
+    }
+    if (cell.gauge.isValid()) {
+        json["gauge"] = gaugeToJson(cell.gauge);
+    }
+
     QJsonArray subCellsArray;
     for (const CellInfo& subCell : cell.subCells) {
         subCellsArray.append(cellToJson(subCell));
@@ -0,0 +1,276 @@
+#include "dashboardmodel.h"
+#include <QPainter>
+
+namespace {
+    // internalId индекса кодирует родителя:
+    //   0                        - колонка (верхний уровень)
+    //   col + 1                  - ячейка колонки col
+    //   ((col + 1) << 16) | (cell + 1) - подъячейка ячейки cell
+    // Колонок и ячеек в колонке меньше 65535, поэтому уровни не пересекаются.
+    const quintptr LevelShift = 16;
+    const quintptr LevelMask = (quintptr(1) << LevelShift) - 1;
+
+    int visibleCells(const ColumnConfig& column)
+    {
+        return qMin(column.cellCount, column.cells.size());
+    }
+
+    QString valueText(const CellInfo& cell)
+    {
+        QString text = cell.value.toString();
+        if (!text.isEmpty() && !cell.unit.isEmpty()) {
+            text += " " + cell.unit;
+        }
+        return text;
+    }
+
+    const int RowHeight = 30;
+}
+
+// --------------------- DashboardModel ---------------------
+
+DashboardModel::DashboardModel(QObject *parent)
+    : QAbstractItemModel(parent)
+{
+}
+
+void DashboardModel::setSnapshot(const ConfigSnapshotPtr& snapshot)
+{
+    beginResetModel();
+    config = snapshot;
+    endResetModel();
+}
+
+const QList<ColumnConfig>& DashboardModel::columns() const
+{
+    static const QList<ColumnConfig> empty;
+    return config ? config->columns : empty;
+}
+
+bool DashboardModel::sameStructure(const QList<ColumnConfig>& other) const
+{
+    const QList<ColumnConfig>& current = columns();
+    if (other.size() != current.size()) return false;
+    for (int col = 0; col < current.size(); ++col) {
+        int count = visibleCells(current[col]);
+        if (visibleCells(other[col]) != count) return false;
+        for (int cell = 0; cell < count; ++cell) {
+            if (other[col].cells[cell].subCells.size() != current[col].cells[cell].subCells.size()) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void DashboardModel::updateValues(const ConfigSnapshotPtr& snapshot)
+{
+    if (snapshot == config) return;
+    if (!snapshot || !sameStructure(snapshot->columns)) {
+        setSnapshot(snapshot);
+        return;
+    }
+
+    // Старый снимок держим до конца сравнения; представление уже читает новый
+    ConfigSnapshotPtr previous = config;
+    config = snapshot;
+    const QList<ColumnConfig>& before = previous ? previous->columns : columns();
+    const QList<ColumnConfig>& after = config->columns;
+
+    const QList<int> roles{ValueTextRole};
+    for (int col = 0; col < after.size(); ++col) {
+        QModelIndex colIndex = index(col, 0);
+        for (int cell = 0; cell < visibleCells(after[col]); ++cell) {
+            const CellInfo& old = before[col].cells[cell];
+            const CellInfo& fresh = after[col].cells[cell];
+            QModelIndex cellIndex = index(cell, 0, colIndex);
+
+            if (!(old.value == fresh.value) || old.unit != fresh.unit) {
+                emit dataChanged(cellIndex, cellIndex, roles);
+            }
+            for (int sub = 0; sub < fresh.subCells.size(); ++sub) {
+                const CellInfo& oldSub = old.subCells[sub];
+                const CellInfo& freshSub = fresh.subCells[sub];
+                if (!(oldSub.value == freshSub.value) || oldSub.unit != freshSub.unit) {
+                    QModelIndex subIndex = index(sub, 0, cellIndex);
+                    emit dataChanged(subIndex, subIndex, roles);
+                }
+            }
+        }
+    }
+}
+
+void DashboardModel::updateCells(const ConfigSnapshotPtr& snapshot, const QVector<CellRef>& changed)
+{
+    if (!snapshot || !config) {
+        setSnapshot(snapshot);
+        return;
+    }
+    config = snapshot;
+
+    const QList<int> roles{ValueTextRole};
+    for (const CellRef& ref : changed) {
+        if (!cellAt(ref)) continue;   // за cellCount - строки нет
+        QModelIndex changedIndex = indexFor(ref);
+        emit dataChanged(changedIndex, changedIndex, roles);
+    }
+}
+
+QModelIndex DashboardModel::indexFor(const CellRef& ref) const
+{
+    if (ref.sub < 0) {
+        return createIndex(ref.cell, 0, quintptr(ref.col + 1));
+    }
+    return createIndex(ref.sub, 0, (quintptr(ref.col + 1) << LevelShift) | quintptr(ref.cell + 1));
+}
+
+CellRef DashboardModel::cellRef(const QModelIndex& index) const
+{
+    CellRef ref;
+    if (!index.isValid()) return ref;
+
+    quintptr id = index.internalId();
+    if (id == 0) {
+        ref.col = index.row();
+    } else if (id <= LevelMask) {
+        ref.col = int(id) - 1;
+        ref.cell = index.row();
+    } else {
+        ref.col = int(id >> LevelShift) - 1;
+        ref.cell = int(id & LevelMask) - 1;
+        ref.sub = index.row();
+    }
+    return ref;
+}
+
+const CellInfo* DashboardModel::cellAt(const CellRef& ref) const
+{
+    const QList<ColumnConfig>& cols = columns();
+    if (ref.col < 0 || ref.col >= cols.size() || ref.cell < 0) return nullptr;
+    const ColumnConfig& column = cols[ref.col];
+    if (ref.cell >= visibleCells(column)) return nullptr;
+    const CellInfo* cell = &column.cells[ref.cell];
+    if (ref.sub >= 0) {
+        if (ref.sub >= cell->subCells.size()) return nullptr;
+        cell = &cell->subCells[ref.sub];
+    }
+    return cell;
+}
+
+QModelIndex DashboardModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (column != 0 || row < 0 || row >= rowCount(parent)) return QModelIndex();
+
+    if (!parent.isValid()) {
+        return createIndex(row, 0, quintptr(0));
+    }
+    CellRef ref = cellRef(parent);
+    if (ref.cell < 0) {
+        return createIndex(row, 0, quintptr(ref.col + 1));
+    }
+    return createIndex(row, 0, (quintptr(ref.col + 1) << LevelShift) | quintptr(ref.cell + 1));
+}
+
+QModelIndex DashboardModel::parent(const QModelIndex& child) const
+{
+    CellRef ref = cellRef(child);
+    if (ref.cell < 0) return QModelIndex();
+    if (ref.sub < 0) return createIndex(ref.col, 0, quintptr(0));
+    return createIndex(ref.cell, 0, quintptr(ref.col + 1));
+}
+
+int DashboardModel::rowCount(const QModelIndex& parent) const
+{
+    const QList<ColumnConfig>& cols = columns();
+    if (!parent.isValid()) return cols.size();
+
+    CellRef ref = cellRef(parent);
+    if (ref.cell < 0) {
+        return ref.col < cols.size() ? visibleCells(cols[ref.col]) : 0;
+    }
+    if (ref.sub >= 0) return 0;   // глубже подъячеек дерево не идет
+    const CellInfo* cell = cellAt(ref);
+    return cell ? cell->subCells.size() : 0;
+}
+
+int DashboardModel::columnCount(const QModelIndex&) const
+{
+    return 1;
+}
+
+QVariant DashboardModel::data(const QModelIndex& index, int role) const
+{
+    CellRef ref = cellRef(index);
+    const QList<ColumnConfig>& cols = columns();
+    if (ref.col < 0 || ref.col >= cols.size()) return QVariant();
+
+    if (ref.cell < 0) {
+        switch (role) {
+        case Qt::DisplayRole: return cols[ref.col].name;
+        case LevelRole: return 0;
+        default: return QVariant();
+        }
+    }
+
+    const CellInfo* cell = cellAt(ref);
+    if (!cell) return QVariant();
+    switch (role) {
+    case Qt::DisplayRole: return cell->content;
+    case ValueTextRole: return valueText(*cell);
+    case IdRole: return cell->id;
+    case ChannelRole: return cell->channel;
+    case LevelRole: return ref.sub < 0 ? 1 : 2;
+    default: return QVariant();
+    }
+}
+
+// --------------------- DashboardDelegate ---------------------
+
+DashboardDelegate::DashboardDelegate(QObject *parent)
+    : QStyledItemDelegate(parent)
+{
+}
+
+QSize DashboardDelegate::sizeHint(const QStyleOptionViewItem& option, const QModelIndex&) const
+{
+    // Одинаковая высота строк - представление не измеряет каждую строку
+    return QSize(option.rect.width(), RowHeight);
+}
+
+void DashboardDelegate::paint(QPainter *painter, const QStyleOptionViewItem& option, const QModelIndex& index) const
+{
+    int level = index.data(DashboardModel::LevelRole).toInt();
+    QRect r = option.rect.adjusted(1, 1, -1, -1);
+    bool selected = option.state & QStyle::State_Selected;
+
+    painter->save();
+
+    // Цвета как у виджетов ячеек: колонка темнее, подъячейка светлее
+    QColor background = level == 0 ? QColor(0xd0, 0xd0, 0xd0)
+                      : level == 1 ? QColor(0xf8, 0xf8, 0xf8)
+                                   : QColor(0xf0, 0xf0, 0xf0);
+    if (selected) background = option.palette.color(QPalette::Highlight).lighter(170);
+    else if (option.state & QStyle::State_MouseOver) background = background.darker(105);
+    painter->fillRect(r, background);
+    painter->setPen(QColor(0x80, 0x80, 0x80));
+    painter->drawRect(r.adjusted(0, 0, -1, -1));
+
+    QRect text = r.adjusted(8, 0, -8, 0);
+    QFont font = option.font;
+    font.setBold(level == 0);
+    painter->setFont(font);
+    painter->setPen(option.palette.color(QPalette::Text));
+
+    QString value = index.data(DashboardModel::ValueTextRole).toString();
+    int valueWidth = value.isEmpty() ? 0 : option.fontMetrics.horizontalAdvance(value) + 12;
+    QString name = option.fontMetrics.elidedText(index.data(Qt::DisplayRole).toString(),
+                                                 Qt::ElideRight, text.width() - valueWidth);
+    painter->drawText(text, Qt::AlignLeft | Qt::AlignVCenter, name);
+    if (!value.isEmpty()) {
+        font.setBold(true);
+        painter->setFont(font);
+        painter->drawText(text, Qt::AlignRight | Qt::AlignVCenter, value);
+    }
+
+    painter->restore();
+}
@@ -0,0 +1,114 @@
+#include "datawatcher.h"
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QFile>
+#include <QTimer>
+#include <QHash>
+#include <QDebug>
+
+DataWatcher::DataWatcher(QObject *parent)
+    : QObject(parent)
+    , watcher(new QFileSystemWatcher(this))
+    , debounceTimer(new QTimer(this))
+    , pollTimer(new QTimer(this))
+{
+    debounceTimer->setSingleShot(true);
+    debounceTimer->setInterval(5);
+
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &DataWatcher::onPathChanged);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &DataWatcher::onPathChanged);
+    connect(debounceTimer, &QTimer::timeout, this, &DataWatcher::check);
+    connect(pollTimer, &QTimer::timeout, this, &DataWatcher::check);
+
+    pollTimer->start(1000);
+}
+
+void DataWatcher::setPath(const QString& path)
+{
+    if (!watcher->files().isEmpty()) {
+        watcher->removePaths(watcher->files());
+    }
+    if (!watcher->directories().isEmpty()) {
+        watcher->removePaths(watcher->directories());
+    }
+
+    filePath = path;
+    last = Fingerprint();
+    updateWatchedPaths();
+}
+
+void DataWatcher::setDebounceInterval(int ms)
+{
+    debounceTimer->setInterval(qMax(0, ms));
+}
+
+void DataWatcher::setPollInterval(int ms)
+{
+    if (ms > 0) {
+        pollTimer->start(ms);
+    } else {
+        pollTimer->stop();
+    }
+}
+
+void DataWatcher::onPathChanged(const QString& path)
+{
+    Q_UNUSED(path);
+    // Писатель может менять файл несколькими write(); ждем окончания пачки
+    debounceTimer->start();
+}
+
+void DataWatcher::updateWatchedPaths()
+{
+    if (filePath.isEmpty()) return;
+
+    QFileInfo info(filePath);
+    QString dir = info.absolutePath();
+    if (!watcher->directories().contains(dir) && QFileInfo::exists(dir)) {
+        watcher->addPath(dir);
+    }
+    // После замены через rename файл пропадает из watcher - добавляем снова
+    if (!watcher->files().contains(filePath) && info.exists()) {
+        watcher->addPath(filePath);
+    }
+}
+
+void DataWatcher::check()
+{
+    if (filePath.isEmpty()) return;
+
+    updateWatchedPaths();
+
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        last = Fingerprint();
+        return;
+    }
+
+    // Дешевая проверка: если время изменения и размер те же - файл не читаем
+    QDateTime modified = info.lastModified();
+    qint64 size = info.size();
+    if (last.valid && last.modified == modified && last.size == size) {
+        return;
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Не удалось открыть файл данных:" << filePath;
+        return;
+    }
+    QByteArray data = file.readAll();
+    file.close();
+
+    size_t hash = qHash(data);
+    bool contentChanged = !last.valid || last.hash != hash || last.size != data.size();
+
+    last.modified = modified;
+    last.size = data.size();
+    last.hash = hash;
+    last.valid = true;
+
+    if (contentChanged) {
+        emit dataChanged(data);
+    }
+}
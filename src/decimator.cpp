@@ -0,0 +1,62 @@
+#include "decimator.h"
+#include <algorithm>
+
+M4Decimator::M4Decimator(double from, double to, int buckets)
+    : from(from)
+    , to(qMax(from, to))
+    , bucketData(qMax(1, buckets))
+{
+    width = (this->to - from) / bucketData.size();
+    if (width <= 0) width = 1;
+}
+
+void M4Decimator::add(double x, double y)
+{
+    if (x < from || x > to) return;
+
+    int index = qMin(int((x - from) / width), bucketData.size() - 1);
+    Bucket& bucket = bucketData[index];
+    QPointF point(x, y);
+
+    if (!bucket.used) {
+        bucket.first = bucket.last = bucket.min = bucket.max = point;
+        bucket.used = true;
+        return;
+    }
+    bucket.last = point;
+    if (y < bucket.min.y()) bucket.min = point;
+    if (y > bucket.max.y()) bucket.max = point;
+}
+
+QVector<QPointF> M4Decimator::result() const
+{
+    QVector<QPointF> out;
+    out.reserve(bucketData.size() * 4);
+
+    for (const Bucket& bucket : bucketData) {
+        if (!bucket.used) continue;
+
+        // Точки интервала в порядке времени, без повторов
+        QPointF points[4] = {bucket.first, bucket.min, bucket.max, bucket.last};
+        std::sort(points, points + 4, [](const QPointF& a, const QPointF& b) { return a.x() < b.x(); });
+        for (const QPointF& p : points) {
+            if (out.isEmpty() || out.last() != p) {
+                out.append(p);
+            }
+        }
+    }
+    return out;
+}
+
+QVector<QPointF> M4Decimator::decimate(const QVector<QPointF>& data, int buckets)
+{
+    if (data.size() <= qMax(1, buckets) * 4) {
+        return data;
+    }
+
+    M4Decimator decimator(data.first().x(), data.last().x(), buckets);
+    for (const QPointF& point : data) {
+        decimator.add(point);
+    }
+    return decimator.result();
+}
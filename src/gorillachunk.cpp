@@ -0,0 +1,171 @@
+#include "gorillachunk.h"
+#include <QtAlgorithms>
+#include <cstring>
+
+namespace {
+    quint64 doubleBits(double value)
+    {
+        quint64 bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    double bitsDouble(quint64 bits)
+    {
+        double value;
+        std::memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+}
+
+GorillaChunk::GorillaChunk()
+    : bitCount(0)
+    , count(0)
+    , first(0)
+    , last(0)
+    , prevTimestamp(0)
+    , prevDelta(0)
+    , prevDuration(0)
+    , prevValue(0)
+    , prevLeading(-1)
+    , prevTrailing(0)
+{
+}
+
+void GorillaChunk::writeBits(quint64 value, int n)
+{
+    // Биты пишутся от старшего к младшему
+    for (int i = n - 1; i >= 0; --i) {
+        if ((bitCount & 7) == 0) {
+            bytes.append('\0');
+        }
+        if ((value >> i) & 1) {
+            bytes[int(bitCount >> 3)] = char(bytes[int(bitCount >> 3)] | (0x80 >> (bitCount & 7)));
+        }
+        ++bitCount;
+    }
+}
+
+// Префиксный код Gorilla для разностей: 0 | 10+7 | 110+9 | 1110+12 | 1111+64 бит
+void GorillaChunk::writeDelta(qint64 delta)
+{
+    if (delta == 0) {
+        writeBits(0, 1);
+    } else if (delta >= -63 && delta <= 64) {
+        writeBits(0b10, 2);
+        writeBits(quint64(delta + 63), 7);
+    } else if (delta >= -255 && delta <= 256) {
+        writeBits(0b110, 3);
+        writeBits(quint64(delta + 255), 9);
+    } else if (delta >= -2047 && delta <= 2048) {
+        writeBits(0b1110, 4);
+        writeBits(quint64(delta + 2047), 12);
+    } else {
+        writeBits(0b1111, 4);
+        writeBits(quint64(delta), 64);
+    }
+}
+
+void GorillaChunk::append(qint64 timestamp, qint64 until, double value)
+{
+    qint64 duration = until - timestamp;
+    quint64 bits = doubleBits(value);
+
+    if (count == 0) {
+        writeBits(quint64(timestamp), 64);
+        writeDelta(duration);
+        writeBits(bits, 64);
+        first = timestamp;
+    } else {
+        qint64 delta = timestamp - prevTimestamp;
+        writeDelta(delta - prevDelta);
+        writeDelta(duration - prevDuration);
+        prevDelta = delta;
+
+        quint64 x = bits ^ prevValue;
+        if (x == 0) {
+            writeBits(0, 1);
+        } else {
+            int leading = qMin(31, int(qCountLeadingZeroBits(x)));
+            int trailing = int(qCountTrailingZeroBits(x));
+            if (prevLeading >= 0 && leading >= prevLeading && trailing >= prevTrailing) {
+                // Значащие биты помещаются в окно предыдущего значения
+                writeBits(0b10, 2);
+                writeBits(x >> prevTrailing, 64 - prevLeading - prevTrailing);
+            } else {
+                int length = 64 - leading - trailing;
+                writeBits(0b11, 2);
+                writeBits(quint64(leading), 5);
+                writeBits(quint64(length - 1), 6);
+                writeBits(x >> trailing, length);
+                prevLeading = leading;
+                prevTrailing = trailing;
+            }
+        }
+    }
+
+    prevTimestamp = timestamp;
+    prevDuration = duration;
+    prevValue = bits;
+    last = until;
+    ++count;
+}
+
+// --------------------- Reader ---------------------
+
+GorillaChunk::Reader::Reader(const GorillaChunk& chunk)
+    : chunk(chunk)
+{
+}
+
+quint64 GorillaChunk::Reader::readBits(int n)
+{
+    const char* data = chunk.bytes.constData();
+    quint64 value = 0;
+    for (int i = 0; i < n; ++i) {
+        int bit = (uchar(data[bitPos >> 3]) >> (7 - (bitPos & 7))) & 1;
+        value = (value << 1) | quint64(bit);
+        ++bitPos;
+    }
+    return value;
+}
+
+qint64 GorillaChunk::Reader::readDelta()
+{
+    if (readBits(1) == 0) return 0;
+    if (readBits(1) == 0) return qint64(readBits(7)) - 63;
+    if (readBits(1) == 0) return qint64(readBits(9)) - 255;
+    if (readBits(1) == 0) return qint64(readBits(12)) - 2047;
+    return qint64(readBits(64));
+}
+
+bool GorillaChunk::Reader::next(qint64* timestamp, qint64* until, double* value)
+{
+    if (index >= chunk.count) return false;
+
+    if (index == 0) {
+        prevTimestamp = qint64(readBits(64));
+        prevDuration = readDelta();
+        prevValue = readBits(64);
+    } else {
+        prevDelta += readDelta();
+        prevTimestamp += prevDelta;
+        prevDuration += readDelta();
+
+        if (readBits(1) == 1) {
+            if (readBits(1) == 1) {
+                prevLeading = int(readBits(5));
+                int length = int(readBits(6)) + 1;
+                prevTrailing = 64 - prevLeading - length;
+            }
+            int length = 64 - prevLeading - prevTrailing;
+            prevValue ^= readBits(length) << prevTrailing;
+        }
+    }
+
+    ++index;
+    *timestamp = prevTimestamp;
+    *until = prevTimestamp + prevDuration;
+    *value = bitsDouble(prevValue);
+    return true;
+}
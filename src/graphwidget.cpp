@@ -1,5 +1,8 @@
 #include "graphwidget.h"
-#include <algorithm>
+#include "decimator.h"
+#include "timeseriesstore.h"
+#include <QDateTime>
+#include <QResizeEvent>
 
 GraphWidget::GraphWidget(QWidget *parent)
     : QWidget(parent)
@@ -10,9 +13,10 @@ GraphWidget::GraphWidget(QWidget *parent)
     chart->addSeries(series);
     chart->legend()->hide();
 
-    axisX = new QValueAxis;
+    axisX = new QDateTimeAxis;
     axisY = new QValueAxis;
     axisX->setTitleText("Время");
+    axisX->setFormat("hh:mm:ss");
     axisY->setTitleText("Значение");
 
     chart->addAxis(axisX, Qt::AlignBottom);
@@ -28,29 +32,85 @@ GraphWidget::GraphWidget(QWidget *parent)
     setLayout(layout);
 }
 
-void GraphWidget::setData(const QVector<double> &data, const QString &cellName)
+int GraphWidget::plotWidth() const
 {
-    series->clear();
+    int plot = int(chart->plotArea().width());
+    return plot > 0 ? plot : width();
+}
 
-    for (int i = 0; i < data.size(); ++i) {
-        series->append(i, data[i]);
-    }
+int GraphWidget::pickTier(qint64 from, qint64 to) const
+{
+    return TimeSeriesStore::tierFor((to - from) / qMax(1, plotWidth()));
+}
 
-    if (data.isEmpty()) {
-        series->append(0, 0);
+void GraphWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    // Область построения пересчитывается позже, поэтому следим за шириной виджета
+    if (event->size().width() != lastWidth) {
+        lastWidth = event->size().width();
+        emit widthChanged(plotWidth());
     }
+}
 
-    axisX->setRange(0, data.size() > 0 ? data.size() - 1 : 10);
+void GraphWidget::setData(const QVector<QPointF> &raw, const QString &cellName)
+{
+    // Подстраховка для вызывающих, которые не прорежили ряд сами
+    const QVector<QPointF> data = M4Decimator::decimate(raw, plotWidth());
+    series->replace(data);
 
-    double minY = 0, maxY = 10;
-    if (!data.isEmpty()) {
-        minY = *std::min_element(data.begin(), data.end());
-        maxY = *std::max_element(data.begin(), data.end());
-        if (minY == maxY) maxY += 1;
+    hasData = false;
+    for (const QPointF &point : data) {
+        includePoint(point);
     }
-    axisY->setRange(minY, maxY);
+    applyRanges();
 
     chart->setTitle(QStringLiteral("График: %1").arg(cellName));
-    chartView->repaint();
 }
 
+bool GraphWidget::appendData(const QVector<QPointF> &points)
+{
+    if (points.isEmpty()) return true;
+
+    // Не больше нескольких точек на пиксель, иначе пора прореживать заново
+    if (series->count() + points.size() > plotWidth() * 8) {
+        return false;
+    }
+
+    series->append(points);
+    for (const QPointF &point : points) {
+        includePoint(point);
+    }
+    applyRanges();
+    return true;
+}
+
+void GraphWidget::includePoint(const QPointF &point)
+{
+    if (!hasData) {
+        minX = maxX = point.x();
+        minY = maxY = point.y();
+        hasData = true;
+        return;
+    }
+    minX = qMin(minX, point.x());
+    maxX = qMax(maxX, point.x());
+    minY = qMin(minY, point.y());
+    maxY = qMax(maxY, point.y());
+}
+
+void GraphWidget::applyRanges()
+{
+    qint64 now = QDateTime::currentMSecsSinceEpoch();
+    qint64 fromX = hasData ? qint64(minX) : now - 10000;
+    qint64 toX = hasData ? qint64(maxX) : now;
+    if (fromX == toX) fromX -= 1000;
+    axisX->setRange(QDateTime::fromMSecsSinceEpoch(fromX), QDateTime::fromMSecsSinceEpoch(toX));
+    // Длинные интервалы подписываем с датой
+    axisX->setFormat(toX - fromX > 24 * 3600 * 1000 ? "dd.MM hh:mm" : "hh:mm:ss");
+
+    double lowY = hasData ? minY : 0;
+    double highY = hasData ? maxY : 10;
+    if (lowY == highY) highY += 1;
+    axisY->setRange(lowY, highY);
+}
@@ -0,0 +1,501 @@
+#include "historyarchive.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QUrl>
+#include <QDebug>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <utility>
+#ifdef Q_OS_UNIX
+#include <unistd.h>
+#endif
+
+namespace {
+    // Заголовок сегмента: сигнатура, версия формата и размер записи
+    const char SegmentMagic[8] = {'H', 'U', 'I', 'H', 'I', 'S', 'T', '1'};
+    const qint64 HeaderSize = 16;
+    const quint32 FormatVersion = 1;
+
+    QByteArray segmentHeader()
+    {
+        QByteArray header(SegmentMagic, sizeof(SegmentMagic));
+        quint32 version = FormatVersion;
+        quint32 recordSize = sizeof(ArchiveRecord);
+        header.append(reinterpret_cast<const char*>(&version), sizeof(version));
+        header.append(reinterpret_cast<const char*>(&recordSize), sizeof(recordSize));
+        return header;
+    }
+
+    // Начала сегментов канала по возрастанию (имя файла - время начала)
+    QList<qint64> segmentStarts(const QString& dir)
+    {
+        QList<qint64> starts;
+        const QStringList files = QDir(dir).entryList(QStringList() << "*.seg", QDir::Files);
+        for (const QString& name : files) {
+            bool ok = false;
+            qint64 start = QFileInfo(name).completeBaseName().toLongLong(&ok);
+            if (ok) starts.append(start);
+        }
+        std::sort(starts.begin(), starts.end());
+        return starts;
+    }
+
+    QString segmentPath(const QString& dir, qint64 start)
+    {
+        return dir + "/" + QString::number(start) + ".seg";
+    }
+
+    QString rollupPath(const QString& dir, qint64 start)
+    {
+        return dir + "/" + QString::number(start) + ".rollup";
+    }
+
+    // Заголовок файла агрегатов; уровни идут за ним подряд
+    const char RollupMagic[8] = {'H', 'U', 'I', 'R', 'O', 'L', 'L', '1'};
+    struct RollupHeader {
+        char magic[8];
+        quint32 version;
+        quint32 recordSize;
+        qint64 sourceRecords;   // записей в сегменте, по которому построен файл
+        quint32 counts[ArchiveRollups::LevelCount];
+        quint32 reserved;
+    };
+    static_assert(sizeof(RollupHeader) == 40, "RollupHeader must stay 40 bytes on disk");
+
+    // Вытеснение давно не читавшихся записей кеша сверх limit; то, что еще
+    // держит вызывающий код, остается отображенным, пока жив его указатель
+    template <typename Cache>
+    void trimCache(Cache& cache, int limit)
+    {
+        if (cache.size() <= limit) return;
+        QVector<quint64> uses;
+        uses.reserve(cache.size());
+        for (const auto& cached : std::as_const(cache)) {
+            uses.append(cached.lastUse);
+        }
+        auto nth = uses.begin() + (uses.size() - limit);
+        std::nth_element(uses.begin(), nth, uses.end());
+        const quint64 keepFrom = *nth;
+        for (auto it = cache.begin(); it != cache.end(); ) {
+            if (it->lastUse < keepFrom) {
+                it = cache.erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+
+    // Сбросить файл из кеша ОС на носитель (вне Unix - только буфер Qt)
+    void syncFile(QFile& file)
+    {
+        file.flush();
+#if defined(Q_OS_LINUX)
+        ::fdatasync(file.handle());
+#elif defined(Q_OS_UNIX)
+        ::fsync(file.handle());
+#endif
+    }
+}
+
+// --------------------- ArchiveSegment ---------------------
+
+ArchiveSegment::~ArchiveSegment()
+{
+    if (map) {
+        file.unmap(map);
+    }
+}
+
+bool ArchiveSegment::open(const QString& path)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    mappedSize = file.size();
+    if (mappedSize < HeaderSize) {
+        file.close();
+        return false;
+    }
+
+    map = file.map(0, mappedSize);
+    // Отображение живет без открытого файла (до unmap или удаления QFile),
+    // поэтому дескриптор не держим: закрытых сегментов может быть тысячи
+    file.close();
+    if (!map || std::memcmp(map, SegmentMagic, sizeof(SegmentMagic)) != 0) {
+        qWarning() << "Поврежденный сегмент истории:" << path;
+        return false;
+    }
+
+    // Неполная запись в хвосте (сбой во время записи) просто не учитывается
+    recordCount = (mappedSize - HeaderSize) / qint64(sizeof(ArchiveRecord));
+    data = reinterpret_cast<const ArchiveRecord*>(map + HeaderSize);
+    return true;
+}
+
+// --------------------- ArchiveRollups ---------------------
+
+ArchiveRollups::~ArchiveRollups()
+{
+    if (map) {
+        file.unmap(map);
+    }
+}
+
+int ArchiveRollups::levelFor(qint64 resolution)
+{
+    for (int level = 0; level < LevelCount; ++level) {
+        if (Resolutions[level] == resolution) return level;
+    }
+    return -1;
+}
+
+bool ArchiveRollups::open(const QString& path, qint64 sourceRecords)
+{
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const qint64 size = file.size();
+    map = size >= qint64(sizeof(RollupHeader)) ? file.map(0, size) : nullptr;
+    file.close();
+    if (!map) return false;
+
+    const RollupHeader* header = reinterpret_cast<const RollupHeader*>(map);
+    if (std::memcmp(header->magic, RollupMagic, sizeof(RollupMagic)) != 0
+        || header->version != FormatVersion
+        || header->recordSize != sizeof(ArchiveRollup)
+        || header->sourceRecords != sourceRecords) {
+        return false;
+    }
+    qint64 total = 0;
+    for (int level = 0; level < LevelCount; ++level) {
+        total += header->counts[level];
+    }
+    if (qint64(sizeof(RollupHeader)) + total * qint64(sizeof(ArchiveRollup)) != size) {
+        return false;
+    }
+
+    const ArchiveRollup* next = reinterpret_cast<const ArchiveRollup*>(map + sizeof(RollupHeader));
+    for (int level = 0; level < LevelCount; ++level) {
+        data[level] = next;
+        counts[level] = header->counts[level];
+        next += counts[level];
+    }
+    return true;
+}
+
+bool ArchiveRollups::build(const ArchiveSegment& segment, const QString& path)
+{
+    // Один проход по записям сразу для всех уровней
+    QVector<ArchiveRollup> levels[LevelCount];
+    const ArchiveRecord* records = segment.records();
+    for (qint64 i = 0; i < segment.count(); ++i) {
+        const ArchiveRecord& record = records[i];
+        const bool repeat = i > 0 && records[i - 1].value == record.value;
+        for (int level = 0; level < LevelCount; ++level) {
+            QVector<ArchiveRollup>& rollups = levels[level];
+            qint64 start = record.timestamp - record.timestamp % Resolutions[level];
+            if (!rollups.isEmpty() && start <= rollups.last().start) {
+                if (repeat || start < rollups.last().start) continue;
+                ArchiveRollup& last = rollups.last();
+                last.min = qMin(last.min, record.value);
+                last.max = qMax(last.max, record.value);
+                last.sum += record.value;
+                ++last.count;
+                continue;
+            }
+            rollups.append(ArchiveRollup{start, record.value, record.value, record.value, 1});
+        }
+    }
+
+    RollupHeader header = {};
+    std::memcpy(header.magic, RollupMagic, sizeof(RollupMagic));
+    header.version = FormatVersion;
+    header.recordSize = sizeof(ArchiveRollup);
+    header.sourceRecords = segment.count();
+    for (int level = 0; level < LevelCount; ++level) {
+        header.counts[level] = quint32(levels[level].size());
+    }
+
+    // Через временный файл: читатель не увидит недописанные агрегаты
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) return false;
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for (const QVector<ArchiveRollup>& rollups : levels) {
+        file.write(reinterpret_cast<const char*>(rollups.constData()),
+                   qint64(rollups.size()) * qint64(sizeof(ArchiveRollup)));
+    }
+    return file.commit();
+}
+
+// --------------------- HistoryArchive ---------------------
+
+HistoryArchive::HistoryArchive()
+    : maxSegmentBytes(DefaultSegmentBytes)
+    , segmentSpanMs(DefaultSegmentSpanMs)
+    , heartbeatMs(DefaultHeartbeatMs)
+{
+}
+
+HistoryArchive::~HistoryArchive()
+{
+    qDeleteAll(writers);
+}
+
+void HistoryArchive::setRootPath(const QString& path)
+{
+    dirtyWriters.clear();   // файлы сбрасываются при удалении писателей
+    qDeleteAll(writers);
+    writers.clear();
+    mappedSegments.clear();
+    mappedRollups.clear();
+    useClock = 0;
+    root = path;
+}
+
+void HistoryArchive::setRotation(qint64 maxBytes, qint64 spanMs)
+{
+    maxSegmentBytes = maxBytes > HeaderSize ? maxBytes : DefaultSegmentBytes;
+    segmentSpanMs = spanMs > 0 ? spanMs : DefaultSegmentSpanMs;
+}
+
+QString HistoryArchive::channelDir(const QString& key) const
+{
+    // id ячейки может содержать '/', поэтому кодируем его в имя каталога
+    return root + "/" + QString::fromLatin1(QUrl::toPercentEncoding(key));
+}
+
+bool HistoryArchive::openSegment(Writer* writer, const QString& key, qint64 start)
+{
+    const QString dir = channelDir(key);
+    if (!QDir().mkpath(dir)) {
+        qWarning() << "Не удалось создать каталог истории:" << dir;
+        return false;
+    }
+
+    // Закрываемый сегмент больше не дописывается - сбрасываем его на носитель
+    if (writer->file.isOpen()) {
+        syncFile(writer->file);
+        writer->file.close();
+        // Сегмент закрыт - сразу строим его агрегаты, пока он в кеше ОС
+        ArchiveSegment sealed;
+        if (sealed.open(segmentPath(dir, writer->segmentStart))
+            && !ArchiveRollups::build(sealed, rollupPath(dir, writer->segmentStart))) {
+            qWarning() << "Не удалось записать агрегаты истории:" << dir;
+        }
+    }
+    writer->file.setFileName(segmentPath(dir, start));
+    if (!writer->file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qWarning() << "Не удалось открыть сегмент истории:" << writer->file.fileName();
+        return false;
+    }
+
+    qint64 size = writer->file.size();
+    if (size < HeaderSize) {
+        writer->file.resize(0);
+        writer->file.write(segmentHeader());
+        syncFile(writer->file);
+    } else {
+        // Отрезаем неполную запись, оставшуюся после сбоя
+        qint64 tail = (size - HeaderSize) % qint64(sizeof(ArchiveRecord));
+        if (tail != 0) {
+            writer->file.resize(size - tail);
+        }
+    }
+
+    writer->size = writer->file.size();
+    writer->segmentStart = start;
+    return true;
+}
+
+HistoryArchive::Writer* HistoryArchive::writerFor(int ch, const QString& key)
+{
+    if (ch < 0) return nullptr;
+    if (ch < writers.size() && writers[ch]) {
+        return writers[ch];
+    }
+    if (root.isEmpty()) return nullptr;
+
+    Writer* writer = new Writer;
+    if (ch >= writers.size()) {
+        writers.resize(ch + 1, nullptr);
+    }
+    writers[ch] = writer;
+
+    // Продолжаем последний сегмент, если он уже есть
+    const QList<qint64> starts = segmentStarts(channelDir(key));
+    if (!starts.isEmpty() && openSegment(writer, key, starts.last())) {
+        ArchiveSegment last;
+        if (last.open(writer->file.fileName()) && last.count() > 0) {
+            const ArchiveRecord& rec = last.records()[last.count() - 1];
+            writer->lastTimestamp = rec.timestamp;
+            writer->lastValue = rec.value;
+            writer->hasLast = true;
+        }
+    }
+    return writer;
+}
+
+void HistoryArchive::append(int ch, const QString& key, qint64 timestamp, double value)
+{
+    Writer* writer = writerFor(ch, key);
+    if (!writer) return;
+
+    if (writer->hasLast) {
+        if (timestamp < writer->lastTimestamp) return; // только дозапись по времени
+        if (writer->lastValue == value && timestamp - writer->lastTimestamp < heartbeatMs) return;
+    }
+
+    // Ротация по размеру и по длительности сегмента.
+    // QFile::size() сбросил бы буфер, поэтому размер считаем сами
+    if (!writer->file.isOpen()
+        || writer->size >= maxSegmentBytes
+        || timestamp - writer->segmentStart >= segmentSpanMs) {
+        if (!openSegment(writer, key, timestamp)) return;
+    }
+
+    ArchiveRecord record{timestamp, value};
+    if (writer->file.write(reinterpret_cast<const char*>(&record), sizeof(record)) != qint64(sizeof(record))) {
+        qWarning() << "Ошибка записи истории:" << writer->file.fileName();
+        return;
+    }
+    writer->size += sizeof(record);
+    if (!writer->dirty) {
+        writer->dirty = true;
+        dirtyWriters.append(writer);
+    }
+
+    writer->lastTimestamp = timestamp;
+    writer->lastValue = value;
+    writer->hasLast = true;
+}
+
+void HistoryArchive::flush()
+{
+    for (Writer* writer : dirtyWriters) {
+        if (writer->file.isOpen() && !writer->file.flush()) {
+            qWarning() << "Ошибка записи истории:" << writer->file.fileName();
+        }
+        writer->dirty = false;
+    }
+    dirtyWriters.clear();
+}
+
+QList<ArchiveSegmentPtr> HistoryArchive::segments(int ch, const QString& key, qint64 from, qint64 to)
+{
+    QList<ArchiveSegmentPtr> result;
+    if (root.isEmpty()) return result;
+    flush();   // дописываемый сегмент отображается с диска
+
+    const QString dir = channelDir(key);
+    const QList<qint64> starts = segmentStarts(dir);
+
+    Writer* writer = writers.value(ch, nullptr);
+    QString activePath = writer && writer->file.isOpen() ? writer->file.fileName() : QString();
+
+    for (int i = 0; i < starts.size(); ++i) {
+        qint64 start = starts[i];
+        qint64 nextStart = i + 1 < starts.size() ? starts[i + 1] : std::numeric_limits<qint64>::max();
+        if (start > to || nextStart <= from) continue;
+
+        QString path = segmentPath(dir, start);
+        if (path == activePath || i + 1 == starts.size()) {
+            // Сегмент еще дописывается - отображаем текущий размер заново
+            auto segment = std::make_shared<ArchiveSegment>();
+            if (segment->open(path)) result.append(segment);
+            continue;
+        }
+
+        Cached<ArchiveSegment>& cached = mappedSegments[path];
+        if (!cached.item) {
+            auto segment = std::make_shared<ArchiveSegment>();
+            if (!segment->open(path)) {
+                mappedSegments.remove(path);
+                continue;
+            }
+            cached.item = segment;
+        }
+        cached.lastUse = ++useClock;
+        result.append(cached.item);
+    }
+    trimCache(mappedSegments, MaxMappedSegments);
+    return result;
+}
+
+bool HistoryArchive::timeRange(int ch, const QString& key, qint64* from, qint64* to)
+{
+    if (root.isEmpty()) return false;
+    Writer* writer = writers.value(ch, nullptr);
+    if (writer && writer->dirty) flush();
+
+    // Сегмент назван временем своей первой записи; конец - последняя запись
+    // последнего (дописываемого) сегмента
+    const QString dir = channelDir(key);
+    const QList<qint64> starts = segmentStarts(dir);
+    if (starts.isEmpty()) return false;
+    *from = starts.first();
+    *to = starts.last();
+    ArchiveSegment last;
+    if (last.open(segmentPath(dir, starts.last())) && last.count() > 0) {
+        *to = qMax(*to, last.records()[last.count() - 1].timestamp);
+    }
+    return true;
+}
+
+ArchiveRollupsPtr HistoryArchive::loadRollups(const QString& dir, qint64 start)
+{
+    // Число записей сегмента - по размеру файла, без его отображения
+    const QString segment = segmentPath(dir, start);
+    const QString path = rollupPath(dir, start);
+    qint64 records = (QFileInfo(segment).size() - HeaderSize) / qint64(sizeof(ArchiveRecord));
+    if (records < 0) return nullptr;
+
+    auto rollups = std::make_shared<ArchiveRollups>();
+    if (rollups->open(path, records)) return rollups;
+
+    // Сегмент закрыт без агрегатов (старый архив или сбой при ротации) - строим один раз
+    ArchiveSegment sealed;
+    if (!sealed.open(segment) || !ArchiveRollups::build(sealed, path)) {
+        qWarning() << "Не удалось построить агрегаты истории:" << segment;
+        return nullptr;
+    }
+    rollups = std::make_shared<ArchiveRollups>();
+    return rollups->open(path, records) ? rollups : nullptr;
+}
+
+QList<ArchiveRollupsPtr> HistoryArchive::rollups(int ch, const QString& key, qint64 from, qint64 to,
+                                                 qint64* sealedEnd)
+{
+    Q_UNUSED(ch);
+    QList<ArchiveRollupsPtr> result;
+    *sealedEnd = std::numeric_limits<qint64>::max();
+    if (root.isEmpty()) return result;
+
+    const QString dir = channelDir(key);
+    const QList<qint64> starts = segmentStarts(dir);
+    if (starts.isEmpty()) return result;
+
+    // Последний сегмент дописывается (или будет продолжен после перезапуска)
+    *sealedEnd = starts.last();
+    for (int i = 0; i + 1 < starts.size(); ++i) {
+        if (starts[i] > to || starts[i + 1] <= from) continue;
+
+        const QString path = rollupPath(dir, starts[i]);
+        Cached<ArchiveRollups>& cached = mappedRollups[path];
+        if (!cached.item) {
+            cached.item = loadRollups(dir, starts[i]);
+            if (!cached.item) {
+                mappedRollups.remove(path);
+                continue;
+            }
+        }
+        cached.lastUse = ++useClock;
+        result.append(cached.item);
+    }
+    trimCache(mappedRollups, MaxMappedSegments);
+    return result;
+}
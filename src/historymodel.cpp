@@ -0,0 +1,151 @@
+#include "historymodel.h"
+#include <QDateTime>
+#include <limits>
+
+namespace {
+    QString timeText(qint64 ms)
+    {
+        return QDateTime::fromMSecsSinceEpoch(ms).toString("dd.MM hh:mm:ss.zzz");
+    }
+}
+
+HistoryModel::HistoryModel(const TimeSeriesStore& store, QObject *parent)
+    : QAbstractTableModel(parent)
+    , store(store)
+{
+}
+
+void HistoryModel::setChannel(int channel)
+{
+    if (channel == ch) return;
+
+    beginResetModel();
+    ch = channel;
+    first = 0;
+    rows = 0;
+    cacheFirst = -1;
+    cache.clear();
+    if (ch >= 0 && store.hasChannel(ch)) {
+        first = store.firstEntry(ch);
+        rows = int(qMin<qint64>(store.entryCount(ch), std::numeric_limits<int>::max()));
+    }
+    endResetModel();
+}
+
+void HistoryModel::refresh()
+{
+    if (ch < 0 || !store.hasChannel(ch)) return;
+
+    qint64 storeFirst = store.firstEntry(ch);
+    qint64 storeEnd = storeFirst + store.entryCount(ch);
+
+    // Вытесненные блоки: строки уходят из начала
+    if (storeFirst > first) {
+        int removed = int(qMin<qint64>(storeFirst - first, rows));
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), 0, removed - 1);
+            rows -= removed;
+            first += removed;
+            endRemoveRows();
+        }
+        first = storeFirst;
+    }
+
+    // Последняя запись могла продлиться (RLE): меняется только "до"
+    if (rows > 0) {
+        QModelIndex last = index(rows - 1, UntilColumn);
+        emit dataChanged(last, last, {Qt::DisplayRole});
+    }
+
+    // Новые записи: строки добавляются в конец
+    qint64 end = first + rows;
+    if (storeEnd > end) {
+        int added = int(qMin<qint64>(storeEnd - end, std::numeric_limits<int>::max() - rows));
+        if (added > 0) {
+            beginInsertRows(QModelIndex(), rows, rows + added - 1);
+            rows += added;
+            endInsertRows();
+        }
+    }
+}
+
+// Строка -> запись хранилища: сначала закрытые блоки, затем открытый, затем кольцо
+bool HistoryModel::sampleAt(int row, Sample* sample) const
+{
+    if (ch < 0 || !store.hasChannel(ch)) return false;
+    qint64 storeFirst = store.firstEntry(ch);
+    qint64 offset = first + row - storeFirst;
+    if (offset < 0) return false;   // запись уже вытеснена, refresh() еще не был вызван
+
+    const FixedRing<GorillaChunk>& sealed = store.sealedChunks(ch);
+    qint64 start = 0;
+    for (int i = 0; i < sealed.size(); ++i) {
+        const GorillaChunk& chunk = sealed.at(i);
+        if (offset < start + chunk.size()) {
+            return chunkSample(chunk, storeFirst + start, int(offset - start), sample);
+        }
+        start += chunk.size();
+    }
+
+    const GorillaChunk& open = store.openChunk(ch);
+    if (offset < start + open.size()) {
+        return chunkSample(open, storeFirst + start, int(offset - start), sample);
+    }
+    start += open.size();
+
+    const SampleRing& ring = store.samples(ch);
+    if (offset - start >= ring.size()) return false;
+    *sample = ring.at(int(offset - start));
+    return true;
+}
+
+bool HistoryModel::chunkSample(const GorillaChunk& chunk, qint64 chunkFirst, int offset, Sample* sample) const
+{
+    // Закрытый блок с тем же началом не меняется, открытый - только растет
+    if (cacheFirst != chunkFirst || cacheSize != chunk.size()) {
+        cache.resize(chunk.size());
+        GorillaChunk::Reader reader(chunk);
+        for (Sample& s : cache) {
+            reader.next(&s.timestamp, &s.until, &s.value);
+        }
+        cacheFirst = chunkFirst;
+        cacheSize = chunk.size();
+    }
+    *sample = cache[offset];
+    return true;
+}
+
+int HistoryModel::rowCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : rows;
+}
+
+int HistoryModel::columnCount(const QModelIndex& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+QVariant HistoryModel::data(const QModelIndex& index, int role) const
+{
+    if (role != Qt::DisplayRole || !index.isValid() || index.row() >= rows) return QVariant();
+
+    Sample sample;
+    if (!sampleAt(index.row(), &sample)) return QVariant();
+    switch (index.column()) {
+    case TimeColumn: return timeText(sample.timestamp);
+    case UntilColumn: return sample.until > sample.timestamp ? timeText(sample.until) : QString();
+    case ValueColumn: return store.formatValue(ch, sample.value);
+    default: return QVariant();
+    }
+}
+
+QVariant HistoryModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole || orientation != Qt::Horizontal) return QVariant();
+    switch (section) {
+    case TimeColumn: return QString("Время");
+    case UntilColumn: return QString("До");
+    case ValueColumn: return QString("Значение");
+    default: return QVariant();
+    }
+}
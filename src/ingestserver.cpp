@@ -0,0 +1,127 @@
+#include "ingestserver.h"
+#include "configmanager.h"
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QUdpSocket>
+#include <QNetworkDatagram>
+#include <QtEndian>
+#include <QDebug>
+
+IngestServer::IngestServer(QObject *parent)
+    : QObject(parent)
+{
+}
+
+void IngestServer::listen(const QString& socketName, int port)
+{
+    if (socketName != localName) {
+        localName = socketName;
+        if (localServer) {
+            localServer->close();
+        }
+        if (!localName.isEmpty()) {
+            if (!localServer) {
+                localServer = new QLocalServer(this);
+                connect(localServer, &QLocalServer::newConnection, this, &IngestServer::onNewConnection);
+            }
+            // Сокет-файл, оставшийся от упавшего процесса, иначе не даст слушать
+            QLocalServer::removeServer(localName);
+            if (!localServer->listen(localName)) {
+                qWarning() << "Не удалось открыть локальный сокет приема:" << localName
+                           << localServer->errorString();
+            }
+        }
+    }
+
+    if (port != udpPort) {
+        udpPort = port;
+        if (udpSocket) {
+            udpSocket->close();
+        }
+        if (udpPort > 0) {
+            if (!udpSocket) {
+                udpSocket = new QUdpSocket(this);
+                connect(udpSocket, &QUdpSocket::readyRead, this, &IngestServer::onUdpReadyRead);
+            }
+            // Только loopback: прием рассчитан на производителей на этой же машине
+            if (!udpSocket->bind(QHostAddress::LocalHost, quint16(udpPort))) {
+                qWarning() << "Не удалось открыть UDP порт приема:" << udpPort << udpSocket->errorString();
+            }
+        }
+    }
+}
+
+void IngestServer::onNewConnection()
+{
+    while (QLocalSocket *client = localServer->nextPendingConnection()) {
+        buffers.insert(client, QByteArray());
+        connect(client, &QLocalSocket::readyRead, this, &IngestServer::onLocalReadyRead);
+        connect(client, &QLocalSocket::disconnected, this, [this, client]() {
+            buffers.remove(client);
+            client->deleteLater();
+        });
+    }
+}
+
+void IngestServer::onLocalReadyRead()
+{
+    QLocalSocket *client = qobject_cast<QLocalSocket*>(sender());
+    auto it = buffers.find(client);
+    if (it == buffers.end()) return;
+
+    it.value() += client->readAll();
+    QList<QByteArray> messages;
+    if (!takeMessages(it.value(), messages)) {
+        qWarning() << "Поток производителя испорчен, соединение закрыто";
+        it.value().clear();
+        client->disconnectFromServer();
+    }
+    if (!messages.isEmpty()) {
+        emit messagesReceived(messages);
+    }
+}
+
+void IngestServer::onUdpReadyRead()
+{
+    // Все датаграммы, накопившиеся к этому событию, - одна пачка
+    QList<QByteArray> messages;
+    while (udpSocket->hasPendingDatagrams()) {
+        QByteArray data = udpSocket->receiveDatagram().data();
+        // Датаграмма самодостаточна: недописанный хвост отбрасывается
+        if (!data.endsWith('\n') && !data.startsWith("HUIB")) data += '\n';
+        takeMessages(data, messages);
+    }
+    if (!messages.isEmpty()) {
+        emit messagesReceived(messages);
+    }
+}
+
+bool IngestServer::takeMessages(QByteArray& buffer, QList<QByteArray>& out)
+{
+    int pos = 0;
+    while (pos < buffer.size()) {
+        const uchar *p = reinterpret_cast<const uchar*>(buffer.constData()) + pos;
+        int available = buffer.size() - pos;
+
+        if (available >= 4 && qFromLittleEndian<quint32>(p) == ConfigManager::BinaryValuesMagic) {
+            if (available < ConfigManager::BinaryValuesHeader) break;
+            quint32 length = qFromLittleEndian<quint32>(p + 4);
+            if (length > quint32(MaxMessageSize)) return false;
+            int frame = ConfigManager::BinaryValuesHeader + int(length);
+            if (available < frame) break;   // кадр еще не дочитан
+            out.append(buffer.mid(pos, frame));
+            pos += frame;
+            continue;
+        }
+        int newline = buffer.indexOf('\n', pos);
+        if (newline < 0) {
+            if (available > MaxMessageSize) return false;
+            break;
+        }
+        QByteArray line = buffer.mid(pos, newline - pos).trimmed();
+        if (!line.isEmpty()) out.append(line);
+        pos = newline + 1;
+    }
+    buffer.remove(0, pos);
+    return true;
+}
@@ -0,0 +1,303 @@
+#include "ingestworker.h"
+#include "datawatcher.h"
+#include "ingestserver.h"
+#include "journaltailer.h"
+#include <QDebug>
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QTimer>
+#include <algorithm>
+#include <limits>
+
+IngestWorker::IngestWorker(QObject *parent)
+    : QObject(parent)
+    , layoutWatcher(nullptr)
+    , valuesWatcher(nullptr)
+    , journalTailer(nullptr)
+    , server(nullptr)
+    , shmTimer(nullptr)
+{
+}
+
+void IngestWorker::start(const QString& layoutPath, const QString& valuesPath, const QString& journalPath)
+{
+    sourcePath = layoutPath;
+
+    // DataWatcher создаем здесь, чтобы их таймеры жили в потоке воркера
+    if (!layoutWatcher) {
+        layoutWatcher = new DataWatcher(this);
+        connect(layoutWatcher, &DataWatcher::dataChanged, this, &IngestWorker::onLayoutChanged);
+    }
+    layoutWatcher->setPath(layoutPath);
+    layoutWatcher->check();
+
+    if (!valuesPath.isEmpty()) {
+        if (!valuesWatcher) {
+            valuesWatcher = new DataWatcher(this);
+            connect(valuesWatcher, &DataWatcher::dataChanged, this, &IngestWorker::onValuesChanged);
+        }
+        valuesWatcher->setPath(valuesPath);
+        valuesWatcher->check();
+    }
+
+    this->journalPath = journalPath;
+    if (!journalPath.isEmpty()) {
+        if (!journalTailer) {
+            journalTailer = new JournalTailer(this);
+            // Строки журнала - те же сообщения значений, что и из сокета
+            connect(journalTailer, &JournalTailer::linesAppended, this, &IngestWorker::applyMessages);
+            connect(journalTailer, &JournalTailer::linesReplayed, this, &IngestWorker::onJournalReplayed);
+            connect(journalTailer, &JournalTailer::replayFinished, this, &IngestWorker::onJournalReplayFinished);
+        }
+        // Без разметки значения журнала некуда положить - откроем его с первой разметкой
+        journalTailer->setPath(current ? journalPath : QString());
+        journalTailer->check();
+    }
+}
+
+void IngestWorker::onLayoutChanged(const QByteArray& data)
+{
+    auto snapshot = std::make_shared<ConfigSnapshot>();
+    snapshot->sourcePath = sourcePath;
+    qint64 timestamp = 0;
+    if (!ConfigManager::parseConfig(data, sourcePath, snapshot->columns, &snapshot->options, &timestamp)) {
+        qWarning() << "Не удалось разобрать данные для обновления:" << sourcePath;
+        return;
+    }
+
+    cellIndex = ConfigManager::buildCellIndex(snapshot->columns);
+    channelRefs = ConfigManager::buildChannelRefs(snapshot->columns);
+    // Разметка сменилась - повторно накладываем последние известные значения
+    if (!lastValues.isEmpty()) {
+        ConfigManager::applyValues(lastValues, cellIndex, snapshot->columns);
+    }
+    // Время от производителя, иначе время приема
+    snapshot->timestamp = timestamp > 0 ? timestamp : QDateTime::currentMSecsSinceEpoch();
+
+    // Тот же файл разметки часто меняется только значениями - тогда GUI
+    // обновит лишь изменившиеся ячейки, а не перестроит все
+    snapshot->layoutChanged = !current
+        || !ConfigManager::diffValues(current->columns, snapshot->columns, snapshot->changedChannels);
+
+    configureSources(snapshot->options);
+
+    current = snapshot;
+    publish(snapshot);
+
+    if (journalTailer && journalTailer->path().isEmpty() && !journalPath.isEmpty()) {
+        journalTailer->setPath(journalPath);
+        journalTailer->check();
+    }
+}
+
+void IngestWorker::configureSources(const ConfigOptions& options)
+{
+    samples.setPolicy(SampleQueue::policyFromString(options.ingestOverflow));
+
+    // Сервер и таймер создаются здесь же, в потоке воркера, и только если нужны
+    if (!server && (!options.ingestSocket.isEmpty() || options.ingestUdpPort > 0)) {
+        server = new IngestServer(this);
+        // Сообщения из сокета в отличие от файла значений не запоминаются:
+        // после смены разметки повторно накладывается только файл
+        connect(server, &IngestServer::messagesReceived, this, &IngestWorker::applyMessages);
+    }
+    if (server) {
+        server->listen(options.ingestSocket, options.ingestUdpPort);
+    }
+
+    shm.setPath(options.ingestShm);
+    if (options.ingestShm.isEmpty()) {
+        if (shmTimer) shmTimer->stop();
+        return;
+    }
+    if (!shmTimer) {
+        shmTimer = new QTimer(this);
+        shmTimer->setTimerType(Qt::PreciseTimer);
+        connect(shmTimer, &QTimer::timeout, this, &IngestWorker::pollShm);
+    }
+    // Кольцо читается с частотой кадров окна: чаще показывать все равно нечего,
+    // а история получает все отсчеты из кольца независимо от частоты чтения
+    int rate = options.uiMaxRate > 0 ? options.uiMaxRate : ConfigOptions::DefaultUiMaxRate;
+    shmTimer->start(qMax(1, 1000 / rate));
+}
+
+void IngestWorker::pollShm()
+{
+    shmBuffer.clear();
+    shm.poll(shmBuffer);
+    if (shmBuffer.isEmpty()) return;
+
+    // Каждый отсчет - в историю; очередь принимает их до снимка с этими значениями
+    for (const SampleRecord& sample : shmBuffer) {
+        samples.push(sample);
+    }
+    samples.flush();
+    if (!current) return;
+
+    // В ячейки - последнее значение канала (отсчеты канала идут подряд).
+    // Время снимка - самое раннее из последних отсчетов каналов: по нему GUI
+    // продлевает плато, и ни один канал не должен уйти дальше своих данных
+    auto snapshot = std::make_shared<ConfigSnapshot>(*current);
+    qint64 timestamp = std::numeric_limits<qint64>::max();
+    int applied = 0;
+    for (int i = 0; i < shmBuffer.size(); ++i) {
+        const SampleRecord& sample = shmBuffer[i];
+        if (i + 1 < shmBuffer.size() && shmBuffer[i + 1].channel == sample.channel) continue;
+        if (sample.channel >= channelRefs.size()) continue;
+        CellInfo *cell = ConfigManager::cellAt(snapshot->columns, channelRefs[sample.channel]);
+        if (!cell) continue;
+        cell->value = CellValue::fromNumber(sample.value);
+        timestamp = qMin(timestamp, sample.timestamp);
+        ++applied;
+    }
+    // Снимок только для окна: его отсчеты уже в очереди, повторно их не кладем
+    if (applied > 0) {
+        publishValues(snapshot, timestamp, false);
+    }
+}
+
+void IngestWorker::onValuesChanged(const QByteArray& data)
+{
+    lastValues = data;
+    applyMessages({data});
+}
+
+void IngestWorker::onJournalReplayed(const QList<QByteArray>& lines)
+{
+    if (!current) return;
+    if (!journalReplay) {
+        journalReplay = std::make_shared<ConfigSnapshot>(*current);
+        journalReplayTimestamp = 0;
+    }
+    // Все строки пишутся в один снимок по порядку: остается последнее значение
+    // каждой ячейки, промежуточные в историю не попадают (они уже в архиве).
+    // Копия на строку стоила бы больше самого разбора, поэтому из поврежденной
+    // строки остаются значения, разобранные до ошибки
+    for (const QByteArray& line : lines) {
+        qint64 timestamp = 0;
+        int applied = line.startsWith("HUIB")
+            ? ConfigManager::applyBinaryValues(line, cellIndex, journalReplay->columns, &timestamp)
+            : ConfigManager::applyValues(line, cellIndex, journalReplay->columns, &timestamp);
+        if (applied > 0 && timestamp > 0) {
+            journalReplayTimestamp = qMax(journalReplayTimestamp, timestamp);
+        }
+    }
+}
+
+void IngestWorker::onJournalReplayFinished()
+{
+    if (!journalReplay) return;
+    std::shared_ptr<ConfigSnapshot> snapshot;
+    snapshot.swap(journalReplay);
+    publishValues(snapshot, journalReplayTimestamp);
+}
+
+void IngestWorker::applyMessages(const QList<QByteArray>& messages)
+{
+    if (!current) return; // разметки еще нет; значения применятся после ее загрузки
+
+    // Сообщения с одним временем (или без времени) ложатся в один снимок.
+    // Сообщение с другим временем начинает новый, чтобы история не потеряла
+    // промежуточные значения из пачки.
+    // Копия списка колонок неявно разделяемая: глубоко копируются только
+    // колонки и ячейки, в которые реально пишутся значения
+    std::shared_ptr<ConfigSnapshot> batch;
+    qint64 batchTimestamp = 0;
+    for (const QByteArray& message : messages) {
+        auto next = std::make_shared<ConfigSnapshot>(batch ? *batch : *current);
+        qint64 timestamp = 0;
+        int applied = message.startsWith("HUIB")
+            ? ConfigManager::applyBinaryValues(message, cellIndex, next->columns, &timestamp)
+            : ConfigManager::applyValues(message, cellIndex, next->columns, &timestamp);
+        if (applied <= 0) continue;
+
+        if (batch && timestamp != batchTimestamp) {
+            publishValues(batch, batchTimestamp);
+        }
+        batch = next;
+        batchTimestamp = timestamp;
+    }
+    if (batch) {
+        publishValues(batch, batchTimestamp);
+    }
+}
+
+void IngestWorker::publishValues(const std::shared_ptr<ConfigSnapshot>& snapshot, qint64 timestamp,
+                                 bool pushValues)
+{
+    snapshot->changedChannels.clear();
+    snapshot->layoutChanged = false;
+    snapshot->timestamp = timestamp > 0 ? timestamp : QDateTime::currentMSecsSinceEpoch();
+    ConfigManager::diffValues(current->columns, snapshot->columns, snapshot->changedChannels);
+
+    current = snapshot;
+    publish(snapshot, pushValues);
+}
+
+void IngestWorker::pushSamples(const ConfigSnapshot& snapshot)
+{
+    QVector<int> changed = snapshot.changedChannels;
+    std::sort(changed.begin(), changed.end());
+    auto push = [&](const CellInfo& cell) {
+        if (cell.channel < 0 || !cell.value.isNumeric()) return;
+        if (!snapshot.layoutChanged && !std::binary_search(changed.begin(), changed.end(), cell.channel)) return;
+        samples.push(SampleRecord{cell.channel, snapshot.timestamp, cell.value.number});
+    };
+
+    for (const ColumnConfig& column : snapshot.columns) {
+        for (const CellInfo& cell : column.cells) {
+            push(cell);
+            for (const CellInfo& sub : cell.subCells) {
+                push(sub);
+            }
+        }
+    }
+    samples.flush();
+}
+
+void IngestWorker::publish(const std::shared_ptr<ConfigSnapshot>& snapshot, bool pushValues)
+{
+    if (pushValues) {
+        pushSamples(*snapshot);
+    }
+    {
+        QMutexLocker locker(&pendingMutex);
+        if (pending.size() >= MaxPendingSnapshots) {
+            // GUI не успевает: вытесняемый снимок сливается с новым,
+            // чтобы GUI не пропустил ни одной изменившейся ячейки
+            ConfigSnapshotPtr dropped = pending.takeLast();
+            snapshot->layoutChanged = snapshot->layoutChanged || dropped->layoutChanged;
+            QVector<int>& changed = snapshot->changedChannels;
+            changed += dropped->changedChannels;
+            std::sort(changed.begin(), changed.end());
+            changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+        }
+        pending.append(snapshot);
+    }
+
+    // Если GUI еще не забрал предыдущие снимки, повторный сигнал не нужен
+    if (!notifyPending.exchange(true)) {
+        emit snapshotReady();
+    }
+}
+
+void IngestWorker::takeSamples(QVector<SampleRecord>& out)
+{
+    const int Batch = 4096;
+    for (;;) {
+        int size = out.size();
+        out.resize(size + Batch);
+        int n = samples.pop(out.data() + size, Batch);
+        out.resize(size + n);
+        if (n < Batch) return;
+    }
+}
+
+QList<ConfigSnapshotPtr> IngestWorker::takeSnapshots()
+{
+    notifyPending.store(false);
+    QMutexLocker locker(&pendingMutex);
+    QList<ConfigSnapshotPtr> taken;
+    taken.swap(pending);
+    return taken;
+}
@@ -0,0 +1,174 @@
+#include "journaltailer.h"
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QFile>
+#include <QTimer>
+#include <QDateTime>
+#include <QDebug>
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace {
+    // Идентичность файла: после ротации или замены журнала по тому же пути
+    // лежит другой файл, даже если он не короче прочитанного.
+    // Пустая - идентичность неизвестна, остается проверка по размеру
+    QByteArray fileIdentity(const QString& path)
+    {
+#ifdef Q_OS_UNIX
+        struct stat st;
+        if (::stat(QFile::encodeName(path).constData(), &st) != 0) return QByteArray();
+        return QByteArray::number(quint64(st.st_dev)) + ':' + QByteArray::number(quint64(st.st_ino));
+#else
+        QDateTime birth = QFileInfo(path).birthTime();
+        return birth.isValid() ? QByteArray::number(birth.toMSecsSinceEpoch()) : QByteArray();
+#endif
+    }
+}
+
+JournalTailer::JournalTailer(QObject *parent)
+    : QObject(parent)
+    , watcher(new QFileSystemWatcher(this))
+    , pollTimer(new QTimer(this))
+{
+    // Без склейки событий: каждая проверка читает только новые байты
+    connect(watcher, &QFileSystemWatcher::fileChanged, this, &JournalTailer::check);
+    connect(watcher, &QFileSystemWatcher::directoryChanged, this, &JournalTailer::check);
+    connect(pollTimer, &QTimer::timeout, this, &JournalTailer::check);
+
+    pollTimer->start(1000);
+}
+
+void JournalTailer::setPath(const QString& path)
+{
+    if (!watcher->files().isEmpty()) {
+        watcher->removePaths(watcher->files());
+    }
+    if (!watcher->directories().isEmpty()) {
+        watcher->removePaths(watcher->directories());
+    }
+
+    filePath = path;
+    offset = -1;
+    partial.clear();
+    identity.clear();
+    updateWatchedPaths();
+}
+
+void JournalTailer::setPollInterval(int ms)
+{
+    if (ms > 0) {
+        pollTimer->start(ms);
+    } else {
+        pollTimer->stop();
+    }
+}
+
+void JournalTailer::updateWatchedPaths()
+{
+    if (filePath.isEmpty()) return;
+
+    QFileInfo info(filePath);
+    QString dir = info.absolutePath();
+    if (!watcher->directories().contains(dir) && QFileInfo::exists(dir)) {
+        watcher->addPath(dir);
+    }
+    if (!watcher->files().contains(filePath) && info.exists()) {
+        watcher->addPath(filePath);
+    }
+}
+
+void JournalTailer::check()
+{
+    if (filePath.isEmpty()) return;
+
+    updateWatchedPaths();
+
+    QFileInfo info(filePath);
+    if (!info.exists()) {
+        // Журнал, созданный после старта, читается с начала
+        offset = 0;
+        partial.clear();
+        identity.clear();
+        return;
+    }
+
+    qint64 size = info.size();
+    QByteArray id = fileIdentity(filePath);
+    if (offset < 0) {
+        identity = id;
+        replay(size);
+        return;
+    }
+    if (size < offset || id != identity) {
+        // Усечен или заменен другим файлом: продолжать со старого смещения
+        // значило бы начать с середины чужой записи
+        offset = 0;
+        partial.clear();
+        identity = id;
+    }
+    if (size == offset) return;
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly) || !file.seek(offset)) {
+        qWarning() << "Не удалось открыть журнал значений:" << filePath;
+        return;
+    }
+    QByteArray chunk = file.read(size - offset);
+    file.close();
+    offset += chunk.size();
+
+    QList<QByteArray> lines = takeLines(chunk);
+    if (!lines.isEmpty()) {
+        emit linesAppended(lines);
+    }
+}
+
+void JournalTailer::replay(qint64 size)
+{
+    // Журнал читается порциями, чтобы большой файл не лег в память целиком
+    offset = 0;
+    partial.clear();
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Не удалось открыть журнал значений:" << filePath;
+        offset = size;
+        emit replayFinished();
+        return;
+    }
+    while (offset < size) {
+        QByteArray chunk = file.read(qMin<qint64>(ReplayChunkSize, size - offset));
+        if (chunk.isEmpty()) break;
+        offset += chunk.size();
+        QList<QByteArray> lines = takeLines(chunk);
+        if (!lines.isEmpty()) {
+            emit linesReplayed(lines);
+        }
+    }
+    file.close();
+    emit replayFinished();
+}
+
+QList<QByteArray> JournalTailer::takeLines(const QByteArray& chunk)
+{
+    QList<QByteArray> lines;
+    partial += chunk;
+    int end = partial.lastIndexOf('\n');
+    if (end < 0) {
+        if (partial.size() > MaxLineSize) {
+            qWarning() << "Слишком длинная строка журнала, пропущена:" << filePath;
+            partial.clear();
+        }
+        return lines;
+    }
+
+    int pos = 0;
+    while (pos <= end) {
+        int newline = partial.indexOf('\n', pos);
+        QByteArray line = partial.mid(pos, newline - pos).trimmed();
+        if (!line.isEmpty()) lines.append(line);
+        pos = newline + 1;
+    }
+    partial.remove(0, end + 1);
+    return lines;
+}
@@ -0,0 +1,254 @@
+#include "jsonstreamreader.h"
+
+JsonStreamReader::JsonStreamReader(const QByteArray& data)
+    : pos(data.constData())
+    , end(data.constData() + data.size())
+    , current(Invalid)
+    , number(0.0)
+    , boolean(false)
+    , expect(ExpectValue)
+{
+}
+
+void JsonStreamReader::skipWhitespace()
+{
+    while (pos < end) {
+        char c = *pos;
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t') {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+}
+
+void JsonStreamReader::valueDone()
+{
+    // После элемента - запятая или закрытие; после корня - конец данных
+    expect = stack.isEmpty() ? ExpectEnd : ExpectComma;
+}
+
+JsonStreamReader::Token JsonStreamReader::next()
+{
+    if (current == End) return End;
+
+    skipWhitespace();
+    if (pos >= end) {
+        // Конец допустим после корневого значения (и для пустых данных)
+        current = stack.isEmpty() && (expect == ExpectEnd || expect == ExpectValue) ? End : Invalid;
+        return current;
+    }
+
+    char c = *pos;
+    if (c == '}' || c == ']') {
+        bool allowed = expect == ExpectComma
+            || (c == '}' && expect == ExpectFirstKey)
+            || (c == ']' && expect == ExpectFirstValue);
+        if (!allowed || stack.isEmpty() || stack.last() != (c == '}' ? '{' : '[')) {
+            return current = Invalid;
+        }
+        ++pos;
+        stack.removeLast();
+        valueDone();
+        return current = (c == '}' ? EndObject : EndArray);
+    }
+
+    if (expect == ExpectEnd) return current = Invalid;
+    if (expect == ExpectComma) {
+        if (c != ',') return current = Invalid;
+        ++pos;
+        expect = stack.last() == '{' ? ExpectKey : ExpectValue;
+        skipWhitespace();
+        if (pos >= end) return current = Invalid;
+        c = *pos;
+    }
+
+    if (expect == ExpectKey || expect == ExpectFirstKey) {
+        if (c != '"' || !readString()) return current = Invalid;
+        skipWhitespace();
+        if (pos >= end || *pos != ':') return current = Invalid;
+        ++pos;
+        expect = ExpectValue;
+        return current = Key;
+    }
+
+    switch (c) {
+    case '{':
+        ++pos;
+        stack.append('{');
+        expect = ExpectFirstKey;
+        return current = BeginObject;
+    case '[':
+        ++pos;
+        stack.append('[');
+        expect = ExpectFirstValue;
+        return current = BeginArray;
+    case '"':
+        if (!readString()) return current = Invalid;
+        valueDone();
+        return current = String;
+    case 't':
+        if (!readLiteral("true", 4)) return current = Invalid;
+        boolean = true;
+        valueDone();
+        return current = Bool;
+    case 'f':
+        if (!readLiteral("false", 5)) return current = Invalid;
+        boolean = false;
+        valueDone();
+        return current = Bool;
+    case 'n':
+        if (!readLiteral("null", 4)) return current = Invalid;
+        valueDone();
+        return current = Null;
+    default:
+        if (c == '-' || (c >= '0' && c <= '9')) {
+            if (!readNumber()) return current = Invalid;
+            valueDone();
+            return current = Number;
+        }
+        return current = Invalid;
+    }
+}
+
+bool JsonStreamReader::readLiteral(const char *literal, int length)
+{
+    if (end - pos < length || QByteArrayView(pos, length) != QByteArrayView(literal, length)) {
+        return false;
+    }
+    pos += length;
+    return true;
+}
+
+bool JsonStreamReader::readNumber()
+{
+    const char *start = pos;
+    while (pos < end) {
+        char c = *pos;
+        if ((c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E') {
+            ++pos;
+        } else {
+            break;
+        }
+    }
+
+    bool ok = false;
+    number = QByteArray::fromRawData(start, int(pos - start)).toDouble(&ok);
+    return ok;
+}
+
+static void appendUtf8(QByteArray& out, uint cp)
+{
+    if (cp < 0x80) {
+        out.append(char(cp));
+    } else if (cp < 0x800) {
+        out.append(char(0xC0 | (cp >> 6)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.append(char(0xE0 | (cp >> 12)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    } else {
+        out.append(char(0xF0 | (cp >> 18)));
+        out.append(char(0x80 | ((cp >> 12) & 0x3F)));
+        out.append(char(0x80 | ((cp >> 6) & 0x3F)));
+        out.append(char(0x80 | (cp & 0x3F)));
+    }
+}
+
+static int hexValue(char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static bool readHex4(const char *&p, const char *end, uint& cp)
+{
+    if (end - p < 4) return false;
+    cp = 0;
+    for (int i = 0; i < 4; ++i) {
+        int h = hexValue(p[i]);
+        if (h < 0) return false;
+        cp = (cp << 4) | uint(h);
+    }
+    p += 4;
+    return true;
+}
+
+bool JsonStreamReader::readString()
+{
+    ++pos; // открывающая кавычка
+    const char *start = pos;
+
+    // Быстрый путь: строка без escape - отдаем срез исходного буфера
+    while (pos < end && *pos != '"' && *pos != '\\') {
+        ++pos;
+    }
+    if (pos >= end) return false;
+    if (*pos == '"') {
+        textView = QByteArrayView(start, pos - start);
+        ++pos;
+        return true;
+    }
+
+    // Медленный путь: раскрываем escape-последовательности во временный буфер
+    scratch.clear();
+    scratch.append(start, int(pos - start));
+    while (pos < end && *pos != '"') {
+        char c = *pos++;
+        if (c != '\\') {
+            scratch.append(c);
+            continue;
+        }
+        if (pos >= end) return false;
+        char e = *pos++;
+        switch (e) {
+        case '"':  scratch.append('"'); break;
+        case '\\': scratch.append('\\'); break;
+        case '/':  scratch.append('/'); break;
+        case 'b':  scratch.append('\b'); break;
+        case 'f':  scratch.append('\f'); break;
+        case 'n':  scratch.append('\n'); break;
+        case 'r':  scratch.append('\r'); break;
+        case 't':  scratch.append('\t'); break;
+        case 'u': {
+            uint cp = 0;
+            if (!readHex4(pos, end, cp)) return false;
+            // Суррогатная пара UTF-16
+            if (cp >= 0xD800 && cp <= 0xDBFF && end - pos >= 6 && pos[0] == '\\' && pos[1] == 'u') {
+                const char *low = pos + 2;
+                uint lo = 0;
+                if (readHex4(low, end, lo) && lo >= 0xDC00 && lo <= 0xDFFF) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+                    pos = low;
+                }
+            }
+            appendUtf8(scratch, cp);
+            break;
+        }
+        default:
+            return false;
+        }
+    }
+    if (pos >= end) return false;
+    ++pos; // закрывающая кавычка
+
+    textView = QByteArrayView(scratch);
+    return true;
+}
+
+bool JsonStreamReader::skipCurrent()
+{
+    if (current != BeginObject && current != BeginArray) {
+        return current != Invalid;
+    }
+
+    const int targetDepth = stack.size() - 1;
+    while (stack.size() > targetDepth) {
+        Token t = next();
+        if (t == Invalid || t == End) return false;
+    }
+    return true;
+}
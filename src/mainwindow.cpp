@@ -21,66 +21,180 @@
 #include <QSplitter>
 #include "mainwindow.h"
 #include <QDockWidget>
+#include <QThread>
+#include <QDateTime>
+#include <limits>
+#include <algorithm>
 #include "graphwidget.h"
+#include "decimator.h"
+#include "plotwidget.h"
+#include "dashboardmodel.h"
+#include "historymodel.h"
+#include <QTableView>
+#include <QTreeView>
+#include <QScrollBar>
+#include <QHeaderView>
+#include <QScreen>
 
 // -------------------------------------------------------------
 // Вспомогательные данные в анонимном пространстве (не трогаем header)
 // -------------------------------------------------------------
 namespace {
-    // История значений: ключ -> список значений (последовательность)
-    QMap<QString, QStringList> g_history;
-
-    // Последний выбранный путь (для отображения в правой панели)
-    int g_lastSelectedCol = -1;
-    int g_lastSelectedCell = -1;
-    QList<int> g_lastSelectedSubPath;
-
-    // Помощник: формирует ключ для истории по индексам- DEPRECATED
-    QString makeHistoryKey(int col, int cell, int sub = -1) {
-        if (col < 0 || cell < 0) return QString();
-        if (sub >= 0) {
-            return QString("col%1/cell%2/sub%3").arg(col).arg(cell).arg(sub);
-        } else {
-            return QString("col%1/cell%2").arg(col).arg(cell);
+    const int SparklineSamples = 120;
+
+    // Шкала индикатора: своя у ячейки, иначе общая из корня конфига, иначе стандартная
+    void applyGaugeScale(TemperatureGauge* gauge, const CellInfo& cell, const ConfigOptions& options)
+    {
+        const GaugeConfig& config = cell.gauge.isValid() ? cell.gauge : options.gauge;
+        if (!config.isValid()) return;
+
+        QVector<GaugeSegment> segments;
+        for (const GaugeBand& band : config.segments) {
+            segments.append(GaugeSegment{band.from, band.to, QColor(band.color)});
+        }
+        gauge->setScale(config.min, config.max, segments);
+    }
+
+    // Точки графика из кольца канала: запись RLE дает начало и конец плато
+    QVector<QPointF> ringPoints(const SampleRing& ring, int first)
+    {
+        QVector<QPointF> points;
+        points.reserve((ring.size() - first) * 2);
+        for (int i = first; i < ring.size(); ++i) {
+            const Sample& sample = ring.at(i);
+            points.append(QPointF(sample.timestamp, sample.value));
+            if (sample.until > sample.timestamp) {
+                points.append(QPointF(sample.until, sample.value));
+            }
+        }
+        return points;
+    }
+
+    // Запас окна графика справа: четверть его длины, но не меньше секунды
+    qint64 windowHeadroom(qint64 from, qint64 to)
+    {
+        return qMax<qint64>((to - from) / 4, 1000);
+    }
+
+    // Спарклайн ячейки по последним отсчетам ее канала. Окно по времени
+    // сдвигается, только когда новые точки вышли за правый край; до этого
+    // начало ряда не меняется и перерисовывается только его хвост
+    void updateSparkline(PlotWidget* spark, const TimeSeriesStore& store, int ch)
+    {
+        if (!spark || !store.hasChannel(ch)) return;
+        const SampleRing& ring = store.samples(ch);
+        if (ring.isEmpty()) return;
+
+        qint64 last = ring.last().until;
+        if (last > spark->xRangeTo() || last < spark->xRangeFrom()) {
+            qint64 from = ring.at(qMax(0, ring.size() - SparklineSamples)).timestamp;
+            spark->setXRange(from, last + windowHeadroom(from, last));
+        }
+
+        // Записи, попадающие в окно, но не больше двух бюджетов спарклайна
+        int first = ring.size();
+        int limit = qMax(0, ring.size() - 2 * SparklineSamples);
+        while (first > limit && ring.at(first - 1).until >= spark->xRangeFrom()) {
+            --first;
+        }
+        spark->setSeriesData(0, ringPoints(ring, first));
+    }
+
+    // Добавляет числовое значение ячейки с меткой времени в историю ее канала
+    // (в память и в архив на диске). Повтор того же значения только продлевает последнюю запись (RLE)
+    void appendToHistory(TimeSeriesStore& store, HistoryArchive& archive, const CellInfo& cell, qint64 timestamp) {
+        if (cell.channel < 0 || !cell.value.isNumeric()) return;
+        int ch = cell.channel;
+        store.ensureChannel(ch, cell.id);
+        store.setCapacity(ch, cell.historyCapacity);
+        store.setFormat(ch, cell.value.kind, cell.unit);
+        store.append(ch, timestamp, cell.value.number);
+        archive.append(ch, cell.id, timestamp, cell.value.number);
+    }
+
+    // Ячейка или подъячейка по положению в дереве
+    const CellInfo* cellAt(const QList<ColumnConfig>& cols, const CellRef& ref, QString* name = nullptr) {
+        if (ref.col < 0 || ref.col >= cols.size()) return nullptr;
+        const ColumnConfig& column = cols[ref.col];
+        if (ref.cell < 0 || ref.cell >= column.cells.size()) return nullptr;
+
+        const CellInfo* cell = &column.cells[ref.cell];
+        if (name) *name = cell->content;
+        if (ref.sub >= 0) {
+            if (ref.sub >= cell->subCells.size()) return nullptr;
+            cell = &cell->subCells[ref.sub];
+            if (name) *name += " / " + cell->content;
+        }
+        return cell;
+    }
+
+    // Текст значения с единицей измерения
+    QString displayText(const CellValue& value, const QString& unit) {
+        QString text = value.toString();
+        if (!text.isEmpty() && !unit.isEmpty()) {
+            text += " " + unit;
+        }
+        return text;
+    }
+
+    QString displayText(const CellInfo& cell) {
+        return displayText(cell.value, cell.unit);
+    }
+
+    // Вид ячейки, от которого зависит состав ее виджетов: виджет с тем же id
+    // и тем же видом переиспользуется при смене раскладки. От значения вид
+    // не зависит: метка и спарклайн есть всегда, спарклайн показывается,
+    // когда значение впервые становится числом
+    QString cellShape(const CellInfo& cell, const ConfigOptions& options)
+    {
+        QStringList parts;
+        parts << cell.content;
+        const GaugeConfig& gauge = cell.gauge.isValid() ? cell.gauge : options.gauge;
+        parts << QString::number(gauge.min) << QString::number(gauge.max);
+        for (const GaugeBand& band : gauge.segments) {
+            parts << QString::number(band.from) << QString::number(band.to) << band.color;
+        }
+        for (const CellInfo& sub : cell.subCells) {
+            parts << sub.id << sub.content;
         }
+        return parts.join(QChar(0x1f));
     }
 
-    // Добавляет value в историю для key, но только если value не пуст и отличается от последней записи
-    void appendToHistory(const QString& key, const QString& value) {
-        if (key.isEmpty() || value.isEmpty()) return;
-        QStringList &list = g_history[key];
-        if (list.isEmpty() || list.last() != value) {
-            list.append(value);
+    // Значение для стрелочного индикатора: своё или первой подъячейки
+    const CellValue* gaugeValue(const CellInfo& cell) {
+        if (!cell.value.isNumeric() && !cell.subCells.isEmpty()) {
+            return &cell.subCells[0].value;
         }
+        return &cell.value;
     }
 }
 
 // Кастомный виджет ячейки с поддержкой кликов
+// Ячейка знает только свой канал: он не меняется при перестановке ячеек,
+// поэтому переиспользованный виджет не нужно обновлять
 class ClickableFrame : public QFrame
 {
     Q_OBJECT
 public:
-    ClickableFrame(int col, int cell, const QList<int>& subCellPath, QWidget* parent = nullptr)
-        : QFrame(parent), m_col(col), m_cell(cell), m_subCellPath(subCellPath)
+    explicit ClickableFrame(int channel, QWidget* parent = nullptr)
+        : QFrame(parent), m_channel(channel)
     {
         setCursor(Qt::PointingHandCursor);
     }
 
 signals:
-    void clicked(int col, int cell, const QList<int>& subCellPath);
+    void clicked(int channel);
 
 protected:
     void mousePressEvent(QMouseEvent* event) override {
         if (event->button() == Qt::LeftButton) {
-            emit clicked(m_col, m_cell, m_subCellPath);
+            emit clicked(m_channel);
         }
         QFrame::mousePressEvent(event);
     }
 
 private:
-    int m_col;
-    int m_cell;
-    QList<int> m_subCellPath;
+    int m_channel;
 };
 
 MainWindow::MainWindow(QWidget *parent)
@@ -102,14 +216,36 @@ MainWindow::MainWindow(QWidget *parent)
         qDebug() << "Используется конфиг по умолчанию";
     }
 
-    // Таймер обновления
-    updateTimer = new QTimer(this);
-    connect(updateTimer, &QTimer::timeout, this, &MainWindow::refreshData);
-    updateTimer->start(1000); // обновление каждую секунду
+    // Прием данных в отдельном потоке: чтение и разбор файла не блокируют GUI,
+    // сюда приходят только готовые снимки
+    ingestThread = new QThread(this);
+    ingestWorker = new IngestWorker;
+    ingestWorker->moveToThread(ingestThread);
+    connect(ingestThread, &QThread::finished, ingestWorker, &QObject::deleteLater);
+    connect(ingestWorker, &IngestWorker::snapshotReady, this, &MainWindow::refreshData);
+    ingestThread->start();
+
+    // Прием данных и перерисовка развязаны: снимки копятся, окно обновляется по таймеру кадра
+    uiTimer = new QTimer(this);
+    uiTimer->setSingleShot(true);
+    uiTimer->setTimerType(Qt::PreciseTimer);
+    connect(uiTimer, &QTimer::timeout, this, &MainWindow::flushUiUpdate);
+    lastUiUpdate.start();
+
+    // config.json - разметка со значениями, values.json - компактный поток только значений,
+    // values.jsonl - журнал изменений значений, читается только дописанное
+    QString dataDir = QCoreApplication::applicationDirPath() + "/../data/";
+    historyArchive.setRootPath(dataDir + "history");
+    QMetaObject::invokeMethod(ingestWorker, [this, dataDir]() {
+        ingestWorker->start(dataDir + "config.json", dataDir + "values.json", dataDir + "values.jsonl");
+    }, Qt::QueuedConnection);
 }
 
 MainWindow::~MainWindow()
 {
+    ingestThread->quit();
+    ingestThread->wait();
+
     if (configManager) {
         configManager->deleteLater();
     }
@@ -155,21 +291,58 @@ void MainWindow::setupUI()
 
     mainSplitter->addWidget(scrollArea);
 
+    // Компактный вид: дерево model/view, рисуются только видимые строки
+    dashboardModel = new DashboardModel(this);
+    dashboardView = new QTreeView(this);
+    dashboardView->setModel(dashboardModel);
+    dashboardView->setItemDelegate(new DashboardDelegate(dashboardView));
+    dashboardView->setHeaderHidden(true);
+    dashboardView->setUniformRowHeights(true);
+    dashboardView->setMouseTracking(true);
+    dashboardView->hide();
+    mainSplitter->addWidget(dashboardView);
+    connect(dashboardView, &QTreeView::clicked, this, [this](const QModelIndex& index) {
+        QVariant channel = index.data(DashboardModel::ChannelRole);
+        if (channel.isValid()) onCellClicked(channel.toInt());
+    });
+
     mainVLayout->addWidget(mainSplitter);
 
 // Создаем правую панель как Dock с вкладками
 QTabWidget *tabWidget = new QTabWidget(this);
 
-// Вкладка "История"
-cellInfoDisplay = new QTextEdit(this);
+// Вкладка "История": сводка по ячейке и таблица истории канала.
+// Таблица - model/view, рисуются только видимые строки
+QWidget *historyTab = new QWidget(this);
+QVBoxLayout *historyLayout = new QVBoxLayout(historyTab);
+historyLayout->setContentsMargins(0, 0, 0, 0);
+cellInfoDisplay = new QTextEdit(historyTab);
 cellInfoDisplay->setReadOnly(true);
 cellInfoDisplay->setPlaceholderText("Выберите ячейку для просмотра информации...");
-tabWidget->addTab(cellInfoDisplay, "История");
+cellInfoDisplay->setMaximumHeight(90);
+historyLayout->addWidget(cellInfoDisplay);
+historyModel = new HistoryModel(historyStore, this);
+historyView = new QTableView(historyTab);
+historyView->setModel(historyModel);
+historyView->verticalHeader()->hide();
+// Фиксированная высота строк - представление не измеряет каждую строку
+historyView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+historyView->verticalHeader()->setDefaultSectionSize(historyView->fontMetrics().height() + 6);
+historyView->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
+historyView->setSelectionBehavior(QAbstractItemView::SelectRows);
+historyLayout->addWidget(historyView);
+tabWidget->addTab(historyTab, "История");
 
 // Вкладка "График"
 graphWidget = new GraphWidget(this);
+connect(graphWidget, &GraphWidget::widthChanged, this, &MainWindow::updateGraph);
 tabWidget->addTab(graphWidget, "График");
 
+// Вкладка "Все каналы" - наложение всех рядов на легком графике
+overlayPlot = new PlotWidget(PlotWidget::Full, this);
+tabWidget->addTab(overlayPlot, "Все каналы");
+connect(tabWidget, &QTabWidget::currentChanged, this, &MainWindow::updateOverlay);
+
 // Dock
 infoDock = new QDockWidget("Информация о ячейке", this);
 infoDock->setWidget(tabWidget);
@@ -207,6 +380,23 @@ void MainWindow::setupMenu()
 
     connect(loadAction, &QAction::triggered, this, &MainWindow::loadConfig);
     connect(saveAction, &QAction::triggered, this, &MainWindow::saveConfig);
+
+    QMenu *viewMenu = menuBar()->addMenu("Вид");
+    QAction *compactAction = new QAction("Компактный список", this);
+    compactAction->setCheckable(true);
+    viewMenu->addAction(compactAction);
+    connect(compactAction, &QAction::toggled, this, &MainWindow::setCompactView);
+}
+
+// Переключение между виджетами ячеек и компактным деревом model/view.
+// В компактном режиме виджеты ячеек не создаются вовсе
+void MainWindow::setCompactView(bool compact)
+{
+    if (compactView == compact) return;
+    compactView = compact;
+    scrollArea->setVisible(!compact);
+    dashboardView->setVisible(compact);
+    createLayoutFromConfig();
 }
 
 void MainWindow::showConfigDialog()
@@ -227,22 +417,16 @@ void MainWindow::showConfigDialog()
 // Температуры пока отдельно не трогаем
 void MainWindow::updateTemperatureGauges()
 {
-    // оставлено пустым (температуры обновляются в updateCellWidget)
+    // оставлено пустым (температуры обновляются в refreshCell)
 }
 
 // --------------------- Виджеты ячеек ---------------------
 // Важное изменение: ставим свойства на ClickableFrame: "col","cell" и для sub - "sub"
-QWidget* MainWindow::createCellWidget(const CellInfo& cellInfo, int colIndex, int cellIndex, const QList<int>& parentPath)
+QWidget* MainWindow::createCellWidget(const CellInfo& cellInfo, int colIndex, int cellIndex)
 {
-    qDebug() << "Создание ячейки:" << colIndex << cellIndex << "content:" << cellInfo.content << "value:" << cellInfo.value << "unit:" << cellInfo.unit;
-    QList<int> currentPath = parentPath;
-    currentPath << cellIndex;
+    qDebug() << "Создание ячейки:" << colIndex << cellIndex << "content:" << cellInfo.content << "value:" << cellInfo.value.toString() << "unit:" << cellInfo.unit;
 
-    ClickableFrame* cellFrame = new ClickableFrame(colIndex, cellIndex, currentPath);
-    // Сохраняем индексы как свойства, чтобы потом при обновлении определить ключ
-    cellFrame->setProperty("col", colIndex);
-    cellFrame->setProperty("cell", cellIndex);
-    // sub не ставим для основной ячейки
+    ClickableFrame* cellFrame = new ClickableFrame(cellInfo.channel);
 
     cellFrame->setFrameStyle(QFrame::Panel | QFrame::Sunken);
     cellFrame->setLineWidth(2);
@@ -264,35 +448,39 @@ QWidget* MainWindow::createCellWidget(const CellInfo& cellInfo, int colIndex, in
     cellLabel->setWordWrap(true);
     mainContentLayout->addWidget(cellLabel, 1);
 
-QString displayValue = cellInfo.value;
-if (!displayValue.isEmpty() && !cellInfo.unit.isEmpty()) {
-    displayValue += " " + cellInfo.unit;
-}
-    if (!displayValue.isEmpty() && !cellInfo.unit.isEmpty()) {
-        displayValue += " " + cellInfo.unit;
-    }
+    QString displayValue = displayText(cellInfo);
+
+    // Виджеты значения запоминаются сразу, чтобы обновлять их без поиска
+    CellWidgets handles;
 
     if (cellInfo.content.contains("Температура", Qt::CaseInsensitive)) {
         TemperatureGauge *tempGauge = new TemperatureGauge;
-        bool ok;
-        double temp = cellInfo.value.toDouble(&ok);
-        if (!ok && !cellInfo.subCells.isEmpty()) {
-            temp = cellInfo.subCells[0].value.toDouble(&ok);
-        }
-        if (ok) tempGauge->setTemperature(temp);
+        applyGaugeScale(tempGauge, cellInfo, configManager->getOptions());
+        const CellValue* temp = gaugeValue(cellInfo);
+        if (temp->isNumeric()) tempGauge->setTemperature(temp->number);
         mainContentLayout->addWidget(tempGauge, 0, Qt::AlignRight);
         temperatureGauges.append(tempGauge);
+        handles.gauge = tempGauge;
     } else {
-        // Создаем value QLabel и даём ему понятное имя (objectName), чтобы найти при обновлении
-if (!displayValue.isEmpty()) {
-    QLabel* valueLabel = new QLabel(displayValue);
-    valueLabel->setObjectName("valueLabel");
-    valueLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
-    mainContentLayout->addWidget(valueLabel);
-}
+        // Метка значения создается и для пустого значения: оно может прийти
+        // позже снимком только со значениями, без перестроения раскладки
+        QLabel* valueLabel = new QLabel(displayValue);
+        valueLabel->setObjectName("valueLabel");
+        valueLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
+        mainContentLayout->addWidget(valueLabel);
+        handles.valueLabel = valueLabel;
+
+        // Спарклайн скрыт, пока значение не станет числом (см. refreshCell)
+        PlotWidget* spark = new PlotWidget(PlotWidget::Sparkline);
+        spark->setObjectName("sparkline");
+        spark->addSeries(cellInfo.id);
+        spark->setVisible(cellInfo.value.isNumeric());
+        mainContentLayout->addWidget(spark);
+        handles.sparkline = spark;
     }
 
     cellLayout->addLayout(mainContentLayout);
+    setCellWidgets(cellInfo.channel, handles);
 
     // Подъячеки
     if (!cellInfo.subCells.isEmpty()) {
@@ -311,7 +499,7 @@ if (!displayValue.isEmpty()) {
         subCellsLayout->setContentsMargins(4, 4, 4, 4);
 
         for (int i = 0; i < cellInfo.subCells.size(); ++i) {
-            QWidget* subCellWidget = createSubCellWidget(cellInfo.subCells[i], colIndex, i, currentPath);
+            QWidget* subCellWidget = createSubCellWidget(cellInfo.subCells[i]);
             subCellsLayout->addWidget(subCellWidget);
         }
 
@@ -323,16 +511,9 @@ if (!displayValue.isEmpty()) {
     return cellFrame;
 }
 
-QWidget* MainWindow::createSubCellWidget(const CellInfo& cellInfo, int colIndex, int subCellIndex, const QList<int>& parentPath)
+QWidget* MainWindow::createSubCellWidget(const CellInfo& cellInfo)
 {
-    QList<int> currentPath = parentPath;
-    currentPath << subCellIndex;
-
-    ClickableFrame* subCellFrame = new ClickableFrame(colIndex, subCellIndex, currentPath);
-    // Сохраняем свойства: col/cell/sub
-    subCellFrame->setProperty("col", colIndex);
-    subCellFrame->setProperty("cell", parentPath.isEmpty() ? -1 : parentPath.last()); // parentPath.last() — индекс основной ячейки
-    subCellFrame->setProperty("sub", subCellIndex);
+    ClickableFrame* subCellFrame = new ClickableFrame(cellInfo.channel);
 
     subCellFrame->setFrameStyle(QFrame::Panel | QFrame::Sunken);
     subCellFrame->setLineWidth(1);
@@ -351,19 +532,8 @@ QWidget* MainWindow::createSubCellWidget(const CellInfo& cellInfo, int colIndex,
     subCellLabel->setWordWrap(true);
     subCellLayout->addWidget(subCellLabel, 1);
 
-    // Подготавливаем displayValue для подъячейки
-    QString displayValue;
-    bool ok;
-    double val = cellInfo.value.toDouble(&ok);
-    if (ok) {
-        displayValue = QString::number(val, 'f', 2);
-    } else if (!cellInfo.value.isEmpty()) {
-        displayValue = cellInfo.value; // строковые значения (время, SN)
-    }
-
-    if (!displayValue.isEmpty() && !cellInfo.unit.isEmpty()) {
-        displayValue += " " + cellInfo.unit;
-    }
+    // Значение уже разобрано при загрузке: число, длительность или строка (SN)
+    QString displayValue = displayText(cellInfo);
 
     // Создаем QLabel для значения подъячейки и даём objectName чтобы обновлять
     QLabel* valueLabel = new QLabel(displayValue);
@@ -371,46 +541,149 @@ QWidget* MainWindow::createSubCellWidget(const CellInfo& cellInfo, int colIndex,
     valueLabel->setAlignment(Qt::AlignRight | Qt::AlignVCenter);
     subCellLayout->addWidget(valueLabel);
 
+    CellWidgets handles;
+    handles.valueLabel = valueLabel;
+
+    PlotWidget* spark = new PlotWidget(PlotWidget::Sparkline);
+    spark->setObjectName("subSparkline");
+    spark->addSeries(cellInfo.id);
+    spark->setVisible(cellInfo.value.isNumeric());
+    subCellLayout->addWidget(spark);
+    handles.sparkline = spark;
+    setCellWidgets(cellInfo.channel, handles);
+
     connect(subCellFrame, &ClickableFrame::clicked, this, &MainWindow::onCellClicked);
 
     return subCellFrame;
 }
 
-// --------------------- Обновление данных (таймер) ---------------------
+// --------------------- Обновление данных (IngestWorker) ---------------------
 void MainWindow::refreshData()
 {
-    QString configPath = QCoreApplication::applicationDirPath() + "/../data/config.json";
-    if (configManager->loadConfig(configPath)) {
-        // обновляем только значения в существующих виджетах
-        updateCellWidgets();
-    } else {
-        qWarning() << "Не удалось загрузить конфиг для обновления:" << configPath;
+    // Отсчеты идут в историю с полной частотой данных через очередь воркера;
+    // виджеты только отмечаются и обновляются не чаще раза за кадр.
+    // Снимки забираются до отсчетов: отсчеты снимка кладутся в очередь раньше него,
+    // поэтому история не отстает от конфигурации, которую увидит окно
+    const QList<ConfigSnapshotPtr> snapshots = ingestWorker->takeSnapshots();
+    sampleBuffer.clear();
+    ingestWorker->takeSamples(sampleBuffer);
+    appendSamples(sampleBuffer);
+    if (snapshots.isEmpty()) return;
+
+    for (const ConfigSnapshotPtr& snapshot : snapshots) {
+        // Изменения снимка отсчитаны от предыдущего снимка воркера. Если с тех пор
+        // конфигурацию меняли здесь (диалог, загрузка файла), снимок заменяет
+        // другую разметку, и ее нужно сверить целиком
+        if (configManager->generation() != workerGeneration) {
+            pendingLayout = true;
+        }
+        configManager->applySnapshot(snapshot);
+        workerGeneration = configManager->generation();
+        pendingLayout = pendingLayout || snapshot->layoutChanged;
+        if (!pendingLayout) {
+            pendingChannels += snapshot->changedChannels;
+        }
     }
+    scheduleUiUpdate();
 }
 
-void MainWindow::updateCellWidgets()
+int MainWindow::uiInterval() const
 {
-    const QList<ColumnConfig>& columns = configManager->getColumns();
+    int rate = configManager->getOptions().uiMaxRate;
+    if (rate <= 0) rate = ConfigOptions::DefaultUiMaxRate;
+    // Чаще, чем обновляется экран, перерисовывать бессмысленно
+    if (QScreen *s = screen()) {
+        int refresh = qRound(s->refreshRate());
+        if (refresh > 0) rate = qMin(rate, refresh);
+    }
+    return qMax(1, 1000 / rate);
+}
 
-    for (int col = 0; col < mainLayout->count(); ++col) {
-        QWidget* columnWidget = mainLayout->itemAt(col)->widget();
-        if (!columnWidget) continue;
+void MainWindow::scheduleUiUpdate()
+{
+    if (uiTimer->isActive()) return;
+    qint64 wait = uiInterval() - lastUiUpdate.elapsed();
+    uiTimer->start(int(qMax<qint64>(0, wait)));
+}
 
-        QVBoxLayout* columnLayout = qobject_cast<QVBoxLayout*>(columnWidget->layout());
-        if (!columnLayout) continue;
+void MainWindow::flushUiUpdate()
+{
+    lastUiUpdate.restart();
+    if (pendingLayout) {
+        // Другая структура - сверка раскладки, значения обновятся вместе с ней
+        pendingLayout = false;
+        pendingChannels.clear();
+        createLayoutFromConfig();
+        return;
+    }
 
-        // Если в конфиге меньше колонок, пропускаем
-        if (col >= columns.size()) continue;
-        const ColumnConfig& columnConfig = columns[col];
+    QVector<int> changed;
+    changed.swap(pendingChannels);
+    std::sort(changed.begin(), changed.end());
+    changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+    updateChangedCells(changed);
+}
 
-        // Пропускаем первый виджет - это заголовок колонки
-        for (int cellIndex = 0; cellIndex < columnConfig.cells.size(); ++cellIndex) {
-            int widgetIndex = cellIndex + 1;
-            if (widgetIndex >= columnLayout->count()) break;
+void MainWindow::appendHistory()
+{
+    // История пишется по конфигу, независимо от того, какие виджеты показаны;
+    // неизменившиеся значения только продлевают свое плато.
+    // Каждый снимок пишется один раз: перестроение раскладки без новых данных историю не трогает
+    if (configManager->generation() == historyGeneration) return;
+    historyGeneration = configManager->generation();
+
+    ConfigSnapshotPtr config = configManager->snapshot();
+    historyStore.setDefaultCapacity(config->options.historyCapacity);
+
+    qint64 now = config->timestamp;
+    if (now <= 0) now = QDateTime::currentMSecsSinceEpoch();
+    for (const ColumnConfig& column : config->columns) {
+        for (const CellInfo& cell : column.cells) {
+            appendToHistory(historyStore, historyArchive, cell, now);
+            for (const CellInfo& sub : cell.subCells) {
+                appendToHistory(historyStore, historyArchive, sub, now);
+            }
+        }
+    }
+    historyArchive.flush();
+}
+
+// Отсчеты изменившихся каналов из очереди воркера. Оформление и емкость
+// каналов берутся из конфига в appendHistory(), который при перерисовке
+// заодно продлевает плато неизменившихся значений
+void MainWindow::appendSamples(const QVector<SampleRecord>& samples)
+{
+    for (const SampleRecord& sample : samples) {
+        if (!historyStore.hasChannel(sample.channel)) {
+            historyStore.ensureChannel(sample.channel, Channels::key(sample.channel));
+        }
+        // Отложенный при переполнении (Coalesce) отсчет может прийти после того,
+        // как appendHistory() уже записал более новое значение канала
+        const SampleRing& ring = historyStore.samples(sample.channel);
+        if (!ring.isEmpty() && sample.timestamp < ring.last().until) continue;
+        historyStore.append(sample.channel, sample.timestamp, sample.value);
+        historyArchive.append(sample.channel, historyStore.channelKey(sample.channel),
+                              sample.timestamp, sample.value);
+    }
+    // На диск - одной пачкой на порцию из очереди, а не по записи
+    historyArchive.flush();
+}
 
-            QWidget* cellWidget = columnLayout->itemAt(widgetIndex)->widget();
-            if (cellWidget) {
-                updateCellWidget(cellWidget, columnConfig.cells[cellIndex]);
+// Полное обновление всех ячеек (после построения раскладки)
+void MainWindow::updateCellWidgets()
+{
+    appendHistory();
+
+    ConfigSnapshotPtr config = configManager->snapshot();
+    if (compactView) {
+        dashboardModel->updateValues(config);
+    } else {
+        for (const ColumnConfig& column : config->columns) {
+            for (const CellInfo& cell : column.cells) {
+                refreshCell(cell);
+                for (const CellInfo& sub : cell.subCells) {
+                    refreshCell(sub);
+                }
             }
         }
     }
@@ -419,77 +692,82 @@ void MainWindow::updateCellWidgets()
     updateRightPanel();
 }
 
-void MainWindow::updateCellWidget(QWidget* cellWidget, const CellInfo& cellInfo)
+// Обновление только изменившихся ячеек по каналам из снимка
+void MainWindow::updateChangedCells(const QVector<int>& changedChannels)
 {
-    // 1) Обновляем основной valueLabel (если есть)
-    QLabel* valueLabel = cellWidget->findChild<QLabel*>("valueLabel");
+    appendHistory();
+
+    ConfigSnapshotPtr config = configManager->snapshot();
+    const QList<ColumnConfig>& columns = config->columns;
+    if (compactView) {
+        // Только строки изменившихся каналов; полное сравнение - при смене разметки
+        QVector<CellRef> refs;
+        refs.reserve(changedChannels.size());
+        for (int ch : changedChannels) {
+            CellRef ref = channelRef(ch);
+            if (ref.col >= 0) refs.append(ref);
+        }
+        dashboardModel->updateCells(config, refs);
+    } else {
+        for (int ch : changedChannels) {
+            // Ячейки без виджета (за cellCount) обновлять нечего
+            if (ch < 0 || ch >= cellWidgets.size()) continue;
+
+            CellRef ref = channelRef(ch);
+            if (ref.col < 0 || ref.col >= columns.size() || ref.cell < 0
+                || ref.cell >= columns[ref.col].cells.size()) {
+                continue;
+            }
+            const CellInfo& cell = columns[ref.col].cells[ref.cell];
+            if (ref.sub < 0) {
+                refreshCell(cell);
+            } else if (ref.sub < cell.subCells.size()) {
+                refreshCell(cell.subCells[ref.sub]);
+                // Индикатор ячейки без своего числа показывает первую подъячейку
+                if (ref.sub == 0) refreshCell(cell);
+            }
+        }
+    }
 
-QString mainDisplay = cellInfo.value;
-if (!mainDisplay.isEmpty() && !cellInfo.unit.isEmpty()) {
-    mainDisplay += " " + cellInfo.unit;
+    updateRightPanel();
 }
 
-
-    if (!mainDisplay.isEmpty() && !cellInfo.unit.isEmpty()) {
-        mainDisplay += " " + cellInfo.unit;
+void MainWindow::setCellWidgets(int channel, const CellWidgets& handles)
+{
+    if (channel < 0) return;
+    if (channel >= cellWidgets.size()) {
+        cellWidgets.resize(channel + 1);
     }
+    cellWidgets[channel] = handles;
+}
 
-    if (valueLabel) {
-        valueLabel->setText(mainDisplay);
-    }
+CellRef MainWindow::channelRef(int channel) const
+{
+    return channel >= 0 && channel < channelRefs.size() ? channelRefs[channel] : CellRef();
+}
+
+void MainWindow::refreshCell(const CellInfo& cellInfo)
+{
+    if (cellInfo.channel < 0 || cellInfo.channel >= cellWidgets.size()) return;
+    const CellWidgets& handles = cellWidgets[cellInfo.channel];
 
-    // 2) Обновляем TemperatureGauge, если есть (работает на основном виджете)
-    QList<TemperatureGauge*> gauges = cellWidget->findChildren<TemperatureGauge*>();
-    for (TemperatureGauge* gauge : gauges) {
-        bool ok;
-        double temp = cellInfo.value.toDouble(&ok);
-        if (!ok && !cellInfo.subCells.isEmpty()) {
-            temp = cellInfo.subCells[0].value.toDouble(&ok);
+    if (handles.valueLabel) {
+        QString text = displayText(cellInfo);
+        if (handles.valueLabel->text() != text) {
+            handles.valueLabel->setText(text);
         }
-        if (ok) gauge->setTemperature(temp);
     }
 
-    // 3) Сохраняем основное значение в историю (если есть)
-    // Для этого берем свойства "col" и "cell" у корневого фрейма
-    QVariant vcol = cellWidget->property("col");
-    QVariant vcell = cellWidget->property("cell");
-    int colIdx = vcol.isValid() ? vcol.toInt() : -1;
-    int cellIdx = vcell.isValid() ? vcell.toInt() : -1;
-    QString mainKey = makeHistoryKey(colIdx, cellIdx, -1);
-    if (!mainDisplay.isEmpty()) appendToHistory(mainKey, mainDisplay);
-
-    // 4) Рекурсивно обновляем подъячейки: ищем фреймы с property "sub"
-    // Мы знаем, что createCellWidget обернул подъячеки в QFrame->QVBoxLayout
-    QList<QFrame*> frames = cellWidget->findChildren<QFrame*>();
-    for (QFrame* f : frames) {
-        // Только те фреймы, которые являются нашим subCellFrame — имеют property "sub"
-        QVariant vsub = f->property("sub");
-        if (!vsub.isValid()) continue; // пропускаем контейнеры без sub
-        int subIdx = vsub.toInt();
-        // Найдём соответствующий CellInfo в массиве
-        if (subIdx >= 0 && subIdx < cellInfo.subCells.size()) {
-            // Найдём QLabel внутри f с objectName "subValueLabel"
-            QLabel* subLabel = f->findChild<QLabel*>("subValueLabel");
-            const CellInfo& subInfo = cellInfo.subCells[subIdx];
-
-            QString subDisplay;
-            bool ok;
-            double subVal = subInfo.value.toDouble(&ok);
-            if (ok) {
-                subDisplay = QString::number(subVal, 'f', 2);
-            } else if (!subInfo.value.isEmpty()) {
-                subDisplay = subInfo.value;
-            }
-            if (!subDisplay.isEmpty() && !subInfo.unit.isEmpty()) {
-                subDisplay += " " + subInfo.unit;
-            }
-            if (subLabel) subLabel->setText(subDisplay);
+    if (handles.gauge) {
+        const CellValue* temp = gaugeValue(cellInfo);
+        if (temp->isNumeric()) handles.gauge->setTemperature(temp->number);
+    }
 
-            // Сохраняем в историю по ключу col/cell/sub
-            QString subKey = makeHistoryKey(colIdx, cellIdx, subIdx);
-            if (!subDisplay.isEmpty()) appendToHistory(subKey, subDisplay);
-        }
+    // Спарклайн по истории канала (история уже дописана)
+    if (handles.sparkline && handles.sparkline->isHidden() && cellInfo.value.isNumeric()) {
+        handles.sparkline->show();
     }
+    updateSparkline(handles.sparkline, historyStore, cellInfo.channel);
 }
 
 // --------------------- Загрузка/сохранение конфигов и layout ---------------------
@@ -536,95 +814,205 @@ void MainWindow::clearLayout(QLayout* layout)
 
 void MainWindow::createLayoutFromConfig()
 {
-    clearLayout(mainLayout);
+    ConfigSnapshotPtr config = configManager->snapshot();
+    const QList<ColumnConfig>& columns = config->columns;
+    channelRefs = ConfigManager::buildChannelRefs(columns);
+
+    if (compactView) {
+        clearLayout(mainLayout);
+        columnWidgets.clear();
+        cellPool.clear();
+        duplicateCells.clear();
+        cellWidgets.clear();
+        temperatureGauges.clear();
+        dashboardModel->setSnapshot(config);
+        dashboardView->expandAll();
+    } else {
+        dashboardModel->setSnapshot(nullptr);
+        reconcileLayout(columns);
+    }
+
+    // Выбор хранится по каналу и переживает перестановку; пропавшая ячейка снимает выбор
+    if (channelRef(selectedChannel).col < 0) {
+        selectedChannel = -1;
+    }
+    updateCellWidgets();
+    updateTemperatureGauges();
+}
+
+QFrame* MainWindow::createColumnFrame(ColumnWidgets& column)
+{
+    QFrame *columnFrame = new QFrame;
+    columnFrame->setFrameStyle(QFrame::Box | QFrame::Raised);
+    columnFrame->setLineWidth(3);
+    columnFrame->setStyleSheet("QFrame { "
+                             "background-color: #e8e8e8; "
+                             "border: 3px solid #707070; "
+                             "border-top: 3px solid #303030; "
+                             "border-left: 3px solid #303030; "
+                             "}");
+
+    QVBoxLayout *columnLayout = new QVBoxLayout(columnFrame);
+    columnLayout->setSpacing(4);
+    columnLayout->setContentsMargins(4, 4, 4, 4);
+
+    QLabel *titleLabel = new QLabel;
+    titleLabel->setAlignment(Qt::AlignCenter);
+    titleLabel->setStyleSheet("QLabel { "
+                            "background-color: #d0d0d0; "
+                            "padding: 10px; "
+                            "font-weight: bold; "
+                            "font-size: 14px; "
+                            "border: 2px solid #606060; "
+                            "border-top: 2px solid #202020; "
+                            "border-left: 2px solid #202020; "
+                            "}");
+    titleLabel->setMinimumHeight(40);
+
+    column.frame = columnFrame;
+    column.title = titleLabel;
+    column.layout = columnLayout;
+    return columnFrame;
+}
 
-    QList<ColumnConfig> columns = configManager->getColumns();
+// Сверка раскладки с новым конфигом вместо полного пересоздания:
+// колонки переиспользуются по номеру, ячейки - по каналу, если их вид не изменился.
+// Создаются только новые и изменившиеся ячейки, удаляются только пропавшие,
+// поэтому прокрутка, выбор и привязка к истории (по каналу) сохраняются.
+void MainWindow::reconcileLayout(const QList<ColumnConfig>& columns)
+{
+    int scrollX = scrollArea->horizontalScrollBar()->value();
+    int scrollY = scrollArea->verticalScrollBar()->value();
+    contentWidget->setUpdatesEnabled(false);
+
+    const ConfigOptions& options = configManager->getOptions();
+    QVector<PooledCell> oldPool;
+    oldPool.swap(cellPool);
+    cellPool.resize(Channels::count());
+
+    // Привязка канала снимается, только если она еще указывает в удаляемый виджет:
+    // подъячейка с тем же id могла уже переехать в другую ячейку
+    auto dropCell = [this](int channel, const PooledCell& pooled) {
+        QVector<int> owned = pooled.subChannels;
+        owned.prepend(channel);
+        for (int ch : owned) {
+            if (ch < 0 || ch >= cellWidgets.size()) continue;
+            const CellWidgets& handles = cellWidgets[ch];
+            QWidget* bound = handles.valueLabel ? static_cast<QWidget*>(handles.valueLabel)
+                           : handles.gauge ? static_cast<QWidget*>(handles.gauge)
+                                           : static_cast<QWidget*>(handles.sparkline);
+            if (bound && pooled.widget->isAncestorOf(bound)) {
+                cellWidgets[ch] = CellWidgets();
+            }
+        }
+        pooled.widget->hide();
+        pooled.widget->deleteLater();
+    };
+    for (QWidget* widget : duplicateCells) {
+        widget->hide();
+        widget->deleteLater();
+    }
+    duplicateCells.clear();
 
     for (int col = 0; col < columns.size(); ++col) {
         const ColumnConfig& columnConfig = columns[col];
+        if (col == columnWidgets.size()) {
+            ColumnWidgets column;
+            mainLayout->addWidget(createColumnFrame(column), 1);
+            columnWidgets.append(column);
+        }
+        ColumnWidgets& column = columnWidgets[col];
+        if (column.title->text() != columnConfig.name) {
+            column.title->setText(columnConfig.name);
+        }
 
-        QFrame *columnFrame = new QFrame;
-        columnFrame->setFrameStyle(QFrame::Box | QFrame::Raised);
-        columnFrame->setLineWidth(3);
-        columnFrame->setStyleSheet("QFrame { "
-                                 "background-color: #e8e8e8; "
-                                 "border: 3px solid #707070; "
-                                 "border-top: 3px solid #303030; "
-                                 "border-left: 3px solid #303030; "
-                                 "}");
-
-        QVBoxLayout *columnLayout = new QVBoxLayout(columnFrame);
-        columnLayout->setSpacing(4);
-        columnLayout->setContentsMargins(4, 4, 4, 4);
-
-        QLabel *titleLabel = new QLabel(columnConfig.name);
-        titleLabel->setAlignment(Qt::AlignCenter);
-        titleLabel->setStyleSheet("QLabel { "
-                                "background-color: #d0d0d0; "
-                                "padding: 10px; "
-                                "font-weight: bold; "
-                                "font-size: 14px; "
-                                "border: 2px solid #606060; "
-                                "border-top: 2px solid #202020; "
-                                "border-left: 2px solid #202020; "
-                                "}");
-        titleLabel->setMinimumHeight(40);
-        columnLayout->addWidget(titleLabel);
+        // Снимаем элементы раскладки; сами виджеты остаются детьми колонки
+        QLayoutItem* item;
+        while ((item = column.layout->takeAt(0)) != nullptr) {
+            delete item;
+        }
+        column.layout->addWidget(column.title);
 
         for (int cell = 0; cell < columnConfig.cellCount && cell < columnConfig.cells.size(); ++cell) {
-            QWidget* cellWidget = createCellWidget(columnConfig.cells[cell], col, cell);
-            columnLayout->addWidget(cellWidget);
+            const CellInfo& info = columnConfig.cells[cell];
+            int ch = info.channel;
+            if (cellPool[ch].widget) {
+                // Повторяющийся в конфиге id: отдельный виджет без обновлений,
+                // каналы остаются привязаны к первой ячейке
+                QVector<int> bound{ch};
+                for (const CellInfo& sub : info.subCells) bound.append(sub.channel);
+                QVector<CellWidgets> saved;
+                for (int c : bound) saved.append(c < cellWidgets.size() ? cellWidgets[c] : CellWidgets());
+                QWidget* duplicate = createCellWidget(info, col, cell);
+                for (int i = 0; i < bound.size(); ++i) setCellWidgets(bound[i], saved[i]);
+                duplicateCells.append(duplicate);
+                column.layout->addWidget(duplicate);
+                continue;
+            }
+            QString shape = cellShape(info, options);
+
+            QWidget* cellWidget = nullptr;
+            if (ch < oldPool.size() && oldPool[ch].widget) {
+                if (oldPool[ch].shape == shape) {
+                    cellWidget = oldPool[ch].widget;
+                } else {
+                    dropCell(ch, oldPool[ch]);
+                }
+                oldPool[ch] = PooledCell();
+            }
+            if (!cellWidget) {
+                cellWidget = createCellWidget(info, col, cell);
+            }
+
+            PooledCell& pooled = cellPool[ch];
+            pooled.widget = cellWidget;
+            pooled.shape = shape;
+            for (const CellInfo& sub : info.subCells) {
+                pooled.subChannels.append(sub.channel);
+            }
+            column.layout->addWidget(cellWidget);
         }
+        column.layout->addStretch();
+    }
 
-        columnLayout->addStretch();
+    // Пропавшие ячейки и лишние колонки (нужные ячейки из них уже перенесены)
+    for (int ch = 0; ch < oldPool.size(); ++ch) {
+        if (oldPool[ch].widget) dropCell(ch, oldPool[ch]);
+    }
+    while (columnWidgets.size() > columns.size()) {
+        ColumnWidgets column = columnWidgets.takeLast();
+        mainLayout->removeWidget(column.frame);
+        column.frame->hide();
+        column.frame->deleteLater();
+    }
 
-        mainLayout->addWidget(columnFrame, 1);
+    temperatureGauges.clear();
+    for (const CellWidgets& handles : cellWidgets) {
+        if (handles.gauge) temperatureGauges.append(handles.gauge);
     }
 
-    // Первичная инициализация истории (можно не обязательно)
-    updateCellWidgets();
-    updateTemperatureGauges();
+    contentWidget->setUpdatesEnabled(true);
+    scrollArea->horizontalScrollBar()->setValue(scrollX);
+    scrollArea->verticalScrollBar()->setValue(scrollY);
 }
 
 // --------------------- Клики и правая панель истории ---------------------
-void MainWindow::onCellClicked(int col, int cell, const QList<int>& subCellPath)
+void MainWindow::onCellClicked(int channel)
 {
-    g_lastSelectedCol = col;
-    g_lastSelectedCell = cell;
-    g_lastSelectedSubPath = subCellPath;
+    selectedChannel = channel;
 
     // Отображаем выбранную ячейку
     const QList<ColumnConfig>& cols = configManager->getColumns();
-    if (col < cols.size()) {
-        const ColumnConfig &column = cols[col];
-        const CellInfo* currentCell = nullptr;
-        QString pathDescription = QString("Колонка: %1").arg(col + 1);
-        QString cellName = "";
-
-        if (subCellPath.size() == 1 && cell < column.cells.size()) {
-            currentCell = &column.cells[cell];
-            cellName = currentCell->content;
-            pathDescription += QString(" → Ячейка: %1").arg(cell + 1);
-        } else if (!subCellPath.isEmpty() && subCellPath[0] < column.cells.size()) {
-            currentCell = &column.cells[subCellPath[0]];
-            pathDescription += QString(" → Ячейка: %1").arg(subCellPath[0] + 1);
-            cellName = currentCell->content;
-
-            for (int i = 1; i < subCellPath.size(); ++i) {
-                int subIndex = subCellPath[i];
-                if (subIndex < currentCell->subCells.size()) {
-                    currentCell = &currentCell->subCells[subIndex];
-                    pathDescription += QString(" → Подъячейка: %1").arg(subIndex + 1);
-                    cellName = currentCell->content;
-                }
-            }
-        }
+    CellRef ref = channelRef(channel);
+    const CellInfo* currentCell = cellAt(cols, ref);
+    if (!currentCell) return;
 
-        if (currentCell) {
-            showCellInfo(pathDescription, cellName, *currentCell);
-            emit cellClicked(); // показываем dock
-        }
+    QString pathDescription = QString("Колонка: %1 → Ячейка: %2").arg(ref.col + 1).arg(ref.cell + 1);
+    if (ref.sub >= 0) {
+        pathDescription += QString(" → Подъячейка: %1").arg(ref.sub + 1);
     }
+    showCellInfo(pathDescription, currentCell->content, *currentCell);
+    emit cellClicked(); // показываем dock
 }
 
 void MainWindow::showCellInfo(const QString& pathDescription, const QString& cellName, const CellInfo& cellInfo)
@@ -635,10 +1023,7 @@ void MainWindow::showCellInfo(const QString& pathDescription, const QString& cel
     infoText += pathDescription + "\n\n";
     infoText += QString("Название: %1\n").arg(cellName);
 
-    QString displayValue = cellInfo.value;
-    if (!displayValue.isEmpty() && !cellInfo.unit.isEmpty()) {
-        displayValue += " " + cellInfo.unit;
-    }
+    QString displayValue = displayText(cellInfo);
 
     if (!displayValue.isEmpty()) {
         infoText += QString("Значение: %1\n").arg(displayValue);
@@ -647,10 +1032,7 @@ void MainWindow::showCellInfo(const QString& pathDescription, const QString& cel
     if (!cellInfo.subCells.isEmpty()) {
         infoText += QString("\nПодъячеек: %1").arg(cellInfo.subCells.size());
         for (int i = 0; i < cellInfo.subCells.size(); ++i) {
-            QString subDisplayValue = cellInfo.subCells[i].value;
-            if (!subDisplayValue.isEmpty() && !cellInfo.subCells[i].unit.isEmpty()) {
-                subDisplayValue += " " + cellInfo.subCells[i].unit;
-            }
+            QString subDisplayValue = displayText(cellInfo.subCells[i]);
             infoText += QString("\n- %1: %2").arg(cellInfo.subCells[i].content).arg(subDisplayValue);
         }
     }
@@ -659,101 +1041,264 @@ void MainWindow::showCellInfo(const QString& pathDescription, const QString& cel
     // Здесь просто временно устанавливаем текст и затем updateRightPanel дополнит/перезапишет.
     cellInfoDisplay->setPlainText(infoText);
 
-    // Обновим правую панель, чтобы включить историю + выбранную ячейку (updateRightPanel делает объединение)
-        QVector<double> values;
-    for (const QString &val : savedValues[cellName])
-        values.append(val.toDouble());
-
-    if (!graphWidget) {
-        graphWidget = new GraphWidget(this);
-        rightPanel->addWidget(graphWidget);
-    }
-
-    graphWidget->setData(values, cellName);
+    // Обновим правую панель, чтобы включить историю + выбранную ячейку (updateRightPanel делает объединение),
+    // график строится там же из числовой истории
     updateRightPanel();
 }
 
 void MainWindow::updateRightPanel()
 {
     QString out;
+    const QList<ColumnConfig>& cols = configManager->getColumns();
 
     // Показ выбранной ячейки
-    if (g_lastSelectedCol >= 0 && g_lastSelectedCell >= 0) {
-        const QList<ColumnConfig>& cols = configManager->getColumns();
-        if (g_lastSelectedCol < cols.size()) {
-            const ColumnConfig &col = cols[g_lastSelectedCol];
-            if (g_lastSelectedCell < col.cells.size()) {
-                const CellInfo &ci = col.cells[g_lastSelectedCell];
-                out += QString("Выбрано: %1 / %2\n").arg(col.name, ci.content);
-
-                if (!ci.value.isEmpty()) {
-                    out += QString("Текущее значение: %1\n\n").arg(ci.value);
-                } else {
-                    out += "\n";
-                }
-            }
+    QString cellName;
+    CellRef selectedRef = channelRef(selectedChannel);
+    const CellInfo* selected = cellAt(cols, selectedRef, &cellName);
+    if (selected) {
+        out += QString("Выбрано: %1 / %2\n").arg(cols[selectedRef.col].name, cellName);
+
+        if (!selected->value.isEmpty()) {
+            out += QString("Текущее значение: %1\n").arg(displayText(*selected));
         }
     }
+    out += QString("Память истории: %1 КБ").arg(historyStore.memoryUsage() / 1024);
+    if (quint64 dropped = ingestWorker->droppedSamples()) {
+        out += QString("\nПотеряно отсчетов при переполнении: %1").arg(dropped);
+    }
+    if (cellInfoDisplay->toPlainText() != out) {
+        cellInfoDisplay->setPlainText(out);
+    }
 
-    // Печатаем всю историю
-    for (auto it = g_history.constBegin(); it != g_history.constEnd(); ++it) {
-        const QString &key = it.key();
-        const QStringList &vals = it.value();
-        if (!vals.isEmpty()) {
-            out += QString("%1: %2\n").arg(key, vals.join(", "));
-        }
+    // Таблица истории догоняет хранилище вставкой новых строк, а не
+    // перепечаткой всего текста; прокручиваем вниз, только если уже были внизу
+    QScrollBar *scroll = historyView->verticalScrollBar();
+    bool atBottom = scroll->value() == scroll->maximum();
+    historyModel->setChannel(selected ? selected->channel : -1);
+    historyModel->refresh();
+    if (atBottom) historyView->scrollToBottom();
+
+    appendGraph();
+    updateOverlay();
+}
+
+// Все каналы на одном графике. Окно по времени сдвигается скачками с запасом
+// справа; в пределах окна каждый ряд дополняется в своем прореживателе только
+// новыми записями, поэтому кадр стоит число изменившихся каналов * ширина,
+// а полный проход по кольцам - только при сдвиге окна
+void MainWindow::updateOverlay()
+{
+    if (!overlayPlot || !overlayPlot->isVisible()) return;
+
+    while (overlayPlot->seriesCount() < historyStore.channelCount()) {
+        overlayPlot->addSeries(historyStore.channelKey(overlayPlot->seriesCount()));
     }
-    cellInfoDisplay->setPlainText(out);
 
-    // Определяем ключ для графика
-    QString key;
-    if (g_lastSelectedCol >= 0 && g_lastSelectedCell >= 0) {
-        if (!g_lastSelectedSubPath.isEmpty() && g_lastSelectedSubPath.size() > 1) {
-            int subIdx = g_lastSelectedSubPath.last();
-            key = makeHistoryKey(g_lastSelectedCol, g_lastSelectedCell, subIdx);
-        } else {
-            key = makeHistoryKey(g_lastSelectedCol, g_lastSelectedCell);
+    qint64 from = std::numeric_limits<qint64>::max();
+    qint64 to = std::numeric_limits<qint64>::min();
+    for (int ch = 0; ch < historyStore.channelCount(); ++ch) {
+        const SampleRing& ring = historyStore.samples(ch);
+        if (ring.isEmpty()) continue;
+        from = qMin(from, ring.at(0).timestamp);
+        to = qMax(to, ring.last().until);
+    }
+    if (from > to) return;
+
+    // Новое окно - когда данные вышли за его края или сменилась ширина графика
+    if (to > overlayTo || from < overlayFrom || overlayPlot->plotWidth() != overlayWidth) {
+        overlayFrom = from;
+        overlayTo = to + windowHeadroom(from, to);
+        overlayWidth = overlayPlot->plotWidth();
+        overlaySeries.clear();
+        overlayPlot->setXRange(overlayFrom, overlayTo);
+    }
+    while (overlaySeries.size() < historyStore.channelCount()) {
+        overlaySeries.append(OverlaySeries{M4Decimator(overlayFrom, overlayTo, overlayWidth)});
+    }
+
+    for (int ch = 0; ch < historyStore.channelCount(); ++ch) {
+        const SampleRing& ring = historyStore.samples(ch);
+        OverlaySeries& series = overlaySeries[ch];
+        qint64 end = historyStore.firstEntry(ch) + historyStore.entryCount(ch);
+        if (end < series.nextEntry) {
+            series = OverlaySeries{M4Decimator(overlayFrom, overlayTo, overlayWidth)};   // канал начат заново
+        }
+        if (ring.isEmpty() || (end == series.nextEntry && ring.last().until == series.lastUntil)) continue;
+
+        // Новые записи - с конца кольца; у последней уже добавленной могло продлиться плато
+        int first = ring.size() - int(qMin<qint64>(end - series.nextEntry, ring.size()));
+        if (first > 0) {
+            const Sample& previous = ring.at(first - 1);
+            series.decimator.add(previous.until, previous.value);
+        }
+        for (int i = first; i < ring.size(); ++i) {
+            const Sample& sample = ring.at(i);
+            series.decimator.add(sample.timestamp, sample.value);
+            if (sample.until > sample.timestamp) {
+                series.decimator.add(sample.until, sample.value);
+            }
         }
+        series.nextEntry = end;
+        series.lastUntil = ring.last().until;
+        overlayPlot->setSeriesData(ch, series.decimator.result());
     }
+}
 
-    if (!key.isEmpty() && g_history.contains(key) && graphWidget) {
-        const QList<ColumnConfig>& cols = configManager->getColumns();
-        QString cellName;
+// Дописывает на график только отсчеты, пришедшие после последней нарисованной точки.
+// Полное перестроение - при смене канала или когда точек стало больше бюджета
+void MainWindow::appendGraph()
+{
+    if (!graphWidget) return;
+    if (selectedChannel < 0 || selectedChannel != graphChannel) {
+        updateGraph();
+        return;
+    }
+    int ch = graphChannel;
+    if (!historyStore.hasChannel(ch)) return;
+
+    // Новые записи - с конца кольца, пока они не старше нарисованного
+    const SampleRing& ring = historyStore.samples(ch);
+    int first = ring.size();
+    while (first > 0 && ring.at(first - 1).until > graphLastX) {
+        --first;
+    }
+
+    QVector<QPointF> fresh;
+    for (int i = first; i < ring.size(); ++i) {
+        const Sample& sample = ring.at(i);
+        if (sample.timestamp > graphLastX) {
+            fresh.append(QPointF(sample.timestamp, sample.value));
+        }
+        // Продление плато, в том числе уже нарисованного
+        if (sample.until > qMax(sample.timestamp, graphLastX)) {
+            fresh.append(QPointF(sample.until, sample.value));
+        }
+    }
+    if (fresh.isEmpty()) return;
 
-        // Название графика с подячейкой
-        if (g_lastSelectedCol >= 0 && g_lastSelectedCell >= 0) {
-            if (g_lastSelectedCol < cols.size()) {
-                const ColumnConfig &col = cols[g_lastSelectedCol];
-                if (g_lastSelectedCell < col.cells.size()) {
-                    const CellInfo &ci = col.cells[g_lastSelectedCell];
-                    cellName = ci.content;
+    if (graphWidget->appendData(fresh)) {
+        graphLastX = qint64(fresh.last().x());
+    } else {
+        updateGraph();
+    }
+}
 
-                    if (!g_lastSelectedSubPath.isEmpty() && g_lastSelectedSubPath.size() > 1) {
-                        int subIdx = g_lastSelectedSubPath.last();
-                        if (subIdx < ci.subCells.size()) {
-                            cellName += " / " + ci.subCells[subIdx].content;
-                        }
-                    }
+// График по каналу выбранной ячейки. Точки из архива и из памяти идут потоком
+// в прореживатель, поэтому стоимость зависит от ширины графика, а не от длины истории
+void MainWindow::updateGraph()
+{
+    if (!graphWidget) return;
+    QString cellName;
+    const CellInfo* selected = cellAt(configManager->getColumns(), channelRef(selectedChannel), &cellName);
+    if (!selected) return;
+    int ch = selected->channel;
+    if (!historyStore.hasChannel(ch)) return;
+
+    const SampleRing& ring = historyStore.samples(ch);
+
+    // Видимый диапазон - от первой точки истории (в том числе в архиве на диске,
+    // до перезапуска) до конца последнего плато в памяти
+    qint64 from = std::numeric_limits<qint64>::max();
+    for (int tier = TimeSeriesStore::Raw; tier < TimeSeriesStore::TierCount; ++tier) {
+        qint64 start = historyStore.tierStart(ch, tier);
+        if (start >= 0) from = qMin(from, start);
+    }
+    qint64 to = ring.isEmpty() ? 0 : ring.last().until;
+    qint64 archiveFrom = 0, archiveTo = 0;
+    if (historyArchive.timeRange(ch, selected->id, &archiveFrom, &archiveTo)) {
+        from = qMin(from, archiveFrom);
+        to = qMax(to, archiveTo);
+    }
+    if (from > to) return;
+
+    // Самый грубый уровень, которого хватает на ширину графика; из архива
+    // берется только то, что старше начала этого уровня в памяти
+    int tier = graphWidget->pickTier(from, to);
+    qint64 memoryStart = historyStore.tierStart(ch, tier);
+    if (memoryStart < 0) memoryStart = std::numeric_limits<qint64>::max();
+
+    M4Decimator decimator(from, to, graphWidget->plotWidth());
+
+    // Закрытые сегменты архива на агрегированном уровне - из их файлов агрегатов
+    // того же разрешения, поэтому обзор суток не читает сырые записи.
+    // Сырые записи - только с начала незакрытого сегмента (или для уровня Raw,
+    // который выбирается лишь на коротком диапазоне); границы - двоичным поиском
+    qint64 rawFrom = from;
+    const qint64 resolution = TimeSeriesStore::tierResolution(tier);
+    const int level = ArchiveRollups::levelFor(resolution);
+    if (level >= 0) {
+        qint64 half = resolution / 2;
+        const QList<ArchiveRollupsPtr> archived =
+            historyArchive.rollups(ch, selected->id, from, memoryStart, &rawFrom);
+        for (const ArchiveRollupsPtr& rollups : archived) {
+            const ArchiveRollup* records = rollups->records(level);
+            for (qint64 i = 0; i < rollups->count(level) && records[i].start < memoryStart; ++i) {
+                decimator.add(qBound(from, records[i].start, to), records[i].min);
+                if (records[i].max != records[i].min) {
+                    decimator.add(qBound(from, records[i].start + half, to), records[i].max);
                 }
             }
         }
-
-        // Конвертируем QStringList в QVector<double>, убирая единицы
-        const QStringList &strList = g_history[key];
-        QVector<double> data;
-        data.reserve(strList.size());
-        for (const QString &s : strList) {
-QString cleaned = s;
-cleaned.remove(QRegularExpression("[^\\d\\-.,]")); // оставляем цифры, точки, минусы, запятые
-cleaned.replace(",", "."); // на случай, если десятичный через запятую
-bool ok = false;
-double val = cleaned.toDouble(&ok);
-if (ok) data.append(val);
+    }
+    auto byTime = [](const ArchiveRecord& record, qint64 timestamp) { return record.timestamp < timestamp; };
+    for (const ArchiveSegmentPtr& segment : historyArchive.segments(ch, selected->id, rawFrom, memoryStart)) {
+        const ArchiveRecord* begin = segment->records();
+        const ArchiveRecord* end = begin + segment->count();
+        const ArchiveRecord* first = std::lower_bound(begin, end, rawFrom, byTime);
+        const ArchiveRecord* last = std::lower_bound(first, end, memoryStart, byTime);
+        for (const ArchiveRecord* record = first; record != last; ++record) {
+            decimator.add(record->timestamp, record->value);
         }
+    }
 
-        // Передаём данные и название в график
-        graphWidget->setData(data, cellName);
+    if (tier == TimeSeriesStore::Raw) {
+        // Запись RLE дает две точки: начало и конец плато
+        auto addSample = [&decimator](qint64 timestamp, qint64 until, double value) {
+            decimator.add(timestamp, value);
+            if (until > timestamp) {
+                decimator.add(until, value);
+            }
+        };
+        // Сначала сжатая часть (последовательное декодирование), затем кольцо
+        auto addChunk = [&addSample](const GorillaChunk& chunk) {
+            GorillaChunk::Reader reader(chunk);
+            qint64 timestamp, until;
+            double value;
+            while (reader.next(&timestamp, &until, &value)) {
+                addSample(timestamp, until, value);
+            }
+        };
+        const FixedRing<GorillaChunk>& sealed = historyStore.sealedChunks(ch);
+        for (int i = 0; i < sealed.size(); ++i) {
+            addChunk(sealed.at(i));
+        }
+        addChunk(historyStore.openChunk(ch));
+        for (int i = 0; i < ring.size(); ++i) {
+            const Sample& sample = ring.at(i);
+            addSample(sample.timestamp, sample.until, sample.value);
+        }
+    } else {
+        // Агрегат дает минимум и максимум своего интервала
+        const RollupRing& rollups = historyStore.rollups(ch, tier);
+        qint64 half = TimeSeriesStore::tierResolution(tier) / 2;
+        for (int i = 0; i < rollups.size(); ++i) {
+            const Rollup& rollup = rollups.at(i);
+            // Начало интервала выровнено по сетке уровня и может выйти за видимый диапазон
+            decimator.add(qBound(from, rollup.start, to), rollup.min);
+            if (rollup.max != rollup.min) {
+                decimator.add(qBound(from, rollup.start + half, to), rollup.max);
+            }
+        }
+        // Последнее плато продлеваем до текущего момента
+        if (!ring.isEmpty() && ring.last().until > ring.last().timestamp) {
+            decimator.add(ring.last().until, ring.last().value);
+        }
     }
+
+    // Передаём данные и название в график
+    graphWidget->setData(decimator.result(), cellName);
+    graphChannel = ch;
+    graphLastX = to;
 }
 
 
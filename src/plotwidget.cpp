@@ -0,0 +1,217 @@
+#include "plotwidget.h"
+#include <QPainter>
+#include <QPaintEvent>
+#include <QDateTime>
+
+namespace {
+    const int LeftMargin = 56;
+    const int RightMargin = 8;
+    const int TopMargin = 8;
+    const int BottomMargin = 22;
+    const int GridLines = 5;
+    // Со сглаживанием ломаные рисуются в разы дольше - только для немногих рядов
+    const int AntialiasSeriesLimit = 16;
+}
+
+PlotWidget::PlotWidget(Style style, QWidget *parent)
+    : QWidget(parent)
+    , style(style)
+{
+    // Фон рисуется самим виджетом (из кеша сетки), очистка не нужна
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    if (style == Sparkline) {
+        setFixedSize(sizeHint());
+    } else {
+        setMinimumSize(200, 150);
+    }
+}
+
+QSize PlotWidget::sizeHint() const
+{
+    return style == Sparkline ? QSize(80, 24) : QSize(400, 300);
+}
+
+int PlotWidget::addSeries(const QString &name, const QColor &color)
+{
+    Series s;
+    s.name = name;
+    // Цвета по кругу оттенков, чтобы соседние ряды различались
+    s.color = color.isValid() ? color : QColor::fromHsv((series.size() * 47) % 360, 200, 200);
+    series.append(s);
+    return series.size() - 1;
+}
+
+void PlotWidget::clearSeries()
+{
+    series.clear();
+    invalidateAll();
+}
+
+QRectF PlotWidget::plotRect() const
+{
+    if (style == Sparkline) {
+        return QRectF(rect()).adjusted(1, 1, -1, -1);
+    }
+    return QRectF(LeftMargin, TopMargin,
+                  width() - LeftMargin - RightMargin,
+                  height() - TopMargin - BottomMargin);
+}
+
+int PlotWidget::plotWidth() const
+{
+    return qMax(1, int(plotRect().width()));
+}
+
+void PlotWidget::setXRange(double from, double to)
+{
+    if (to <= from) to = from + 1;
+    if (from == xFrom && to == xTo) return;
+    xFrom = from;
+    xTo = to;
+    invalidateAll();
+}
+
+void PlotWidget::setSeriesData(int index, const QVector<QPointF> &points)
+{
+    if (index < 0 || index >= series.size()) return;
+    Series &s = series[index];
+
+    // Общее начало старых и новых данных не перерисовываем
+    int common = 0;
+    int n = qMin(s.points.size(), points.size());
+    while (common < n && s.points[common] == points[common]) {
+        ++common;
+    }
+    if (common == points.size() && common == s.points.size()) return;
+    double dirtyFromX = common > 0 ? points[common - 1].x() : xFrom;
+
+    s.points = points;
+    s.mapped = false;
+    if (!points.isEmpty()) {
+        s.minY = s.maxY = points.first().y();
+        for (const QPointF &point : points) {
+            s.minY = qMin(s.minY, point.y());
+            s.maxY = qMax(s.maxY, point.y());
+        }
+    }
+
+    double oldMin = yMin, oldMax = yMax;
+    updateYRange();
+    if (yMin != oldMin || yMax != oldMax) {
+        invalidateAll();
+        return;
+    }
+
+    // Масштаб не изменился - грязная только область справа от общего начала
+    QRectF area = plotRect();
+    double px = area.left() + (dirtyFromX - xFrom) / (xTo - xFrom) * area.width();
+    int left = int(qBound(area.left(), px, area.right())) - 2;
+    update(QRect(left, 0, width() - left, height()));
+}
+
+// Автомасштаб по y из кешированных границ рядов: O(число рядов)
+void PlotWidget::updateYRange()
+{
+    bool any = false;
+    double low = 0, high = 1;
+    for (const Series &s : series) {
+        if (s.points.isEmpty()) continue;
+        low = any ? qMin(low, s.minY) : s.minY;
+        high = any ? qMax(high, s.maxY) : s.maxY;
+        any = true;
+    }
+    if (low == high) {
+        low -= 0.5;
+        high += 0.5;
+    }
+    yMin = low;
+    yMax = high;
+}
+
+void PlotWidget::mapSeries(Series &s) const
+{
+    QRectF area = plotRect();
+    double sx = area.width() / (xTo - xFrom);
+    double sy = area.height() / (yMax - yMin);
+
+    s.polyline.resize(s.points.size());
+    for (int i = 0; i < s.points.size(); ++i) {
+        const QPointF &point = s.points[i];
+        s.polyline[i] = QPointF(area.left() + (point.x() - xFrom) * sx,
+                                area.bottom() - (point.y() - yMin) * sy);
+    }
+    s.mapped = true;
+}
+
+void PlotWidget::invalidateAll()
+{
+    for (Series &s : series) {
+        s.mapped = false;
+    }
+    gridDirty = true;
+    update();
+}
+
+void PlotWidget::rebuildGrid()
+{
+    qreal dpr = devicePixelRatioF();
+    gridCache = QPixmap(size() * dpr);
+    gridCache.setDevicePixelRatio(dpr);
+    gridCache.fill(palette().color(QPalette::Base));
+    gridDirty = false;
+    if (style == Sparkline) return;
+
+    QPainter p(&gridCache);
+    QRectF area = plotRect();
+    QString timeFormat = xTo - xFrom > 24 * 3600 * 1000 ? "dd.MM hh:mm" : "hh:mm:ss";
+
+    for (int i = 0; i <= GridLines; ++i) {
+        double x = area.left() + area.width() * i / GridLines;
+        double y = area.bottom() - area.height() * i / GridLines;
+
+        p.setPen(QColor(225, 225, 225));
+        p.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom()));
+        p.drawLine(QPointF(area.left(), y), QPointF(area.right(), y));
+
+        p.setPen(palette().color(QPalette::Text));
+        qint64 t = qint64(xFrom + (xTo - xFrom) * i / GridLines);
+        p.drawText(QRectF(x - 40, area.bottom() + 2, 80, BottomMargin - 2),
+                   Qt::AlignHCenter | Qt::AlignTop,
+                   QDateTime::fromMSecsSinceEpoch(t).toString(timeFormat));
+        double value = yMin + (yMax - yMin) * i / GridLines;
+        p.drawText(QRectF(0, y - 8, LeftMargin - 4, 16),
+                   Qt::AlignRight | Qt::AlignVCenter,
+                   QString::number(value, 'g', 4));
+    }
+
+    p.setPen(palette().color(QPalette::Mid));
+    p.drawRect(area);
+}
+
+void PlotWidget::paintEvent(QPaintEvent *event)
+{
+    QPainter p(this);
+    QRect dirty = event->rect();
+
+    if (gridDirty || gridCache.size() != size() * devicePixelRatioF()) {
+        rebuildGrid();
+    }
+    qreal dpr = gridCache.devicePixelRatio();
+    p.drawPixmap(dirty.topLeft(), gridCache,
+                 QRectF(dirty.x() * dpr, dirty.y() * dpr, dirty.width() * dpr, dirty.height() * dpr));
+
+    p.setClipRect(dirty & plotRect().toAlignedRect());
+    p.setRenderHint(QPainter::Antialiasing, series.size() <= AntialiasSeriesLimit);
+    for (Series &s : series) {
+        if (s.points.isEmpty()) continue;
+        if (!s.mapped) mapSeries(s);
+        p.setPen(QPen(s.color, style == Sparkline ? 1.0 : 1.5));
+        p.drawPolyline(s.polyline);
+    }
+}
+
+void PlotWidget::resizeEvent(QResizeEvent *event)
+{
+    QWidget::resizeEvent(event);
+    invalidateAll();
+}
@@ -0,0 +1,125 @@
+#include "samplequeue.h"
+#include <cstring>
+
+namespace {
+    // Потребитель забирает отсчеты пачками не больше этой: пока пачка
+    // читается, производитель с DropOldest может сдвинуть head, и тогда
+    // чтение повторяется. Короткая пачка - короткое окно для такой гонки
+    const int PopBatch = 256;
+
+    quint64 roundUpPow2(int capacity)
+    {
+        quint64 size = 2;
+        while (size < quint64(qMax(2, capacity))) size <<= 1;
+        return size;
+    }
+}
+
+SampleQueue::SampleQueue(int capacity)
+{
+    quint64 size = roundUpPow2(capacity);
+    slots.reset(new Slot[size]);
+    mask = size - 1;
+}
+
+SampleQueue::OverflowPolicy SampleQueue::policyFromString(const QString& name, OverflowPolicy fallback)
+{
+    if (name == "dropOldest") return DropOldest;
+    if (name == "dropNewest") return DropNewest;
+    if (name == "coalesce") return Coalesce;
+    return fallback;
+}
+
+void SampleQueue::write(quint64 position, const SampleRecord& sample)
+{
+    Slot& slot = slots[position & mask];
+    quint64 bits;
+    std::memcpy(&bits, &sample.value, sizeof(bits));
+    slot.channel.store(sample.channel, std::memory_order_relaxed);
+    slot.timestamp.store(sample.timestamp, std::memory_order_relaxed);
+    slot.valueBits.store(bits, std::memory_order_relaxed);
+    // Публикация слота: потребитель читает tail с acquire
+    tail.store(position + 1, std::memory_order_release);
+}
+
+bool SampleQueue::tryPush(const SampleRecord& sample)
+{
+    quint64 t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) > mask) return false;   // полна
+    write(t, sample);
+    return true;
+}
+
+void SampleQueue::push(const SampleRecord& sample)
+{
+    // Пока отложенные отсчеты не дописаны, новые встают за ними,
+    // иначе по каналу нарушился бы порядок времени
+    if (!coalesced.isEmpty()) {
+        flush();
+        if (!coalesced.isEmpty()) {
+            auto it = coalesced.find(sample.channel);
+            if (it != coalesced.end()) {
+                *it = sample;
+                dropped.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                coalesced.insert(sample.channel, sample);
+            }
+            return;
+        }
+    }
+
+    if (tryPush(sample)) return;
+
+    switch (overflow) {
+    case DropNewest:
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    case Coalesce:
+        coalesced.insert(sample.channel, sample);
+        return;
+    case DropOldest: {
+        // Забираем у потребителя самый старый слот. Если CAS не прошел,
+        // потребитель сам только что освободил место
+        quint64 h = head.load(std::memory_order_acquire);
+        if (head.compare_exchange_strong(h, h + 1, std::memory_order_acq_rel)) {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+        }
+        write(tail.load(std::memory_order_relaxed), sample);
+        return;
+    }
+    }
+}
+
+void SampleQueue::flush()
+{
+    for (auto it = coalesced.begin(); it != coalesced.end(); ) {
+        if (!tryPush(it.value())) return;
+        it = coalesced.erase(it);
+    }
+}
+
+int SampleQueue::pop(SampleRecord* out, int max)
+{
+    int total = 0;
+    while (total < max) {
+        quint64 h = head.load(std::memory_order_acquire);
+        quint64 t = tail.load(std::memory_order_acquire);
+        int n = int(qMin<quint64>(qMin<quint64>(t - h, mask + 1), quint64(qMin(max - total, PopBatch))));
+        if (n <= 0) break;
+
+        SampleRecord* batch = out + total;
+        for (int i = 0; i < n; ++i) {
+            const Slot& slot = slots[(h + i) & mask];
+            quint64 bits = slot.valueBits.load(std::memory_order_relaxed);
+            batch[i].channel = slot.channel.load(std::memory_order_relaxed);
+            batch[i].timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            std::memcpy(&batch[i].value, &bits, sizeof(bits));
+        }
+        // Если производитель вытеснил часть пачки, пока мы читали, -
+        // прочитанное могло быть перезаписано, читаем заново с нового head
+        if (head.compare_exchange_strong(h, h + n, std::memory_order_acq_rel)) {
+            total += n;
+        }
+    }
+    return total;
+}
@@ -0,0 +1,123 @@
+#include "shmingest.h"
+#include "shmring.h"
+#include "configmanager.h"
+#include <QDebug>
+
+namespace {
+    const int RetryInterval = 1000;   // мс между попытками открыть кольцо
+
+    int channelFor(const ShmRing::ChannelHeader* header)
+    {
+        int length = int(qstrnlen(header->id, ShmRing::IdSize));
+        if (length == 0 || length == ShmRing::IdSize) return -1;   // нет id или нет нуля в конце
+        return Channels::idFor(QString::fromUtf8(header->id, length));
+    }
+}
+
+void ShmIngest::setPath(const QString& path)
+{
+    if (path == filePath) return;
+    close();
+    filePath = path;
+    lastAttempt.invalidate();
+}
+
+bool ShmIngest::open()
+{
+    lastAttempt.start();
+    file.setFileName(filePath);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    const qint64 size = file.size();
+    uchar *mapped = size >= qint64(sizeof(ShmRing::Header)) ? file.map(0, size) : nullptr;
+    const ShmRing::Header *header = reinterpret_cast<const ShmRing::Header*>(mapped);
+    if (!header || header->magic.load(std::memory_order_acquire) != ShmRing::Magic
+        || header->version != ShmRing::Version
+        || header->slotCount == 0 || (header->slotCount & (header->slotCount - 1)) != 0
+        || ShmRing::fileSize(header->channelCount, header->slotCount) != size) {
+        if (mapped) file.unmap(mapped);
+        file.close();
+        return false;
+    }
+
+    base = mapped;
+    slotCount = header->slotCount;
+    channels.resize(int(header->channelCount));
+    for (quint32 ch = 0; ch < header->channelCount; ++ch) {
+        const ShmRing::ChannelHeader *channelHeader = ShmRing::channel(base, ch);
+        Channel& channel = channels[int(ch)];
+        channel.channel = channelFor(channelHeader);
+        // Сразу забираем все, что еще лежит в кольце
+        quint64 written = channelHeader->written.load(std::memory_order_acquire);
+        channel.next = written > slotCount ? written - slotCount : 0;
+    }
+    qDebug() << "Открыто разделяемое кольцо:" << filePath << channels.size() << "каналов по" << slotCount;
+    return true;
+}
+
+void ShmIngest::close()
+{
+    if (base) {
+        file.unmap(base);
+        base = nullptr;
+    }
+    file.close();
+    channels.clear();
+}
+
+void ShmIngest::poll(QVector<SampleRecord>& out)
+{
+    if (filePath.isEmpty()) return;
+    if (!base) {
+        if (lastAttempt.isValid() && lastAttempt.elapsed() < RetryInterval) return;
+        if (!open()) return;
+    }
+    const ShmRing::Header *header = reinterpret_cast<const ShmRing::Header*>(base);
+    if (header->magic.load(std::memory_order_acquire) != ShmRing::Magic) {
+        // Писатель закрыл кольцо; новое откроем, когда оно появится
+        close();
+        lastAttempt.start();
+        return;
+    }
+
+    const quint64 mask = slotCount - 1;
+    for (int ch = 0; ch < channels.size(); ++ch) {
+        Channel& channel = channels[ch];
+        const ShmRing::ChannelHeader *channelHeader = ShmRing::channel(base, quint32(ch));
+        quint64 written = channelHeader->written.load(std::memory_order_acquire);
+        if (written == channel.next) continue;
+        if (channel.channel < 0) {
+            // id мог появиться после открытия кольца
+            channel.channel = channelFor(channelHeader);
+            if (channel.channel < 0) {
+                channel.next = written;
+                continue;
+            }
+        }
+        if (written < channel.next) {
+            channel.next = written;   // писатель начал канал заново
+            continue;
+        }
+        if (written - channel.next > slotCount) {
+            dropped.fetch_add(written - slotCount - channel.next, std::memory_order_relaxed);
+            channel.next = written - slotCount;
+        }
+
+        const ShmRing::Slot *ring = ShmRing::slots(base, quint32(ch));
+        for (quint64 i = channel.next; i < written; ++i) {
+            const ShmRing::Slot& slot = ring[i & mask];
+            quint64 seq = slot.seq.load(std::memory_order_acquire);
+            qint64 timestamp = slot.timestamp.load(std::memory_order_relaxed);
+            quint64 bits = slot.valueBits.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (seq != 2 * i + 2 || slot.seq.load(std::memory_order_relaxed) != seq) {
+                dropped.fetch_add(1, std::memory_order_relaxed);   // перезаписан следующим кругом, пока мы читали
+                continue;
+            }
+            SampleRecord sample{channel.channel, timestamp, 0.0};
+            std::memcpy(&sample.value, &bits, sizeof(bits));
+            out.append(sample);
+        }
+        channel.next = written;
+    }
+}
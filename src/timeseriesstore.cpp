@@ -0,0 +1,195 @@
+#include "timeseriesstore.h"
+
+namespace {
+    const qint64 TierResolutions[TimeSeriesStore::TierCount] = {0, 1000, 60 * 1000, 3600 * 1000};
+    // 1 с - час, 1 мин - сутки, 1 ч - месяц
+    const int TierCapacities[TimeSeriesStore::TierCount] = {0, 3600, 1440, 720};
+
+    // extension - повтор последнего значения (продление плато). Он не
+    // учитывается в уже открытом интервале, иначе частые повторы
+    // раздували бы count и тянули среднее к значению плато; интервал,
+    // в который плато перешло, открывается им с count = 1.
+    void addToRollup(RollupRing& ring, qint64 resolution, qint64 timestamp, double value, bool extension)
+    {
+        qint64 start = timestamp - timestamp % resolution;
+        if (!ring.isEmpty()) {
+            Rollup& last = ring.last();
+            if (start < last.start) return;   // опоздавший отсчет в агрегаты не попадает
+            if (start == last.start) {
+                if (extension) return;
+                last.min = qMin(last.min, value);
+                last.max = qMax(last.max, value);
+                last.sum += value;
+                ++last.count;
+                return;
+            }
+        }
+        ring.append(Rollup{start, value, value, value, 1});
+    }
+}
+
+// --------------------- TimeSeriesStore ---------------------
+
+TimeSeriesStore::TimeSeriesStore()
+    : defaultSize(DefaultCapacity)
+    , sealedLimit(DefaultSealedChunks)
+{
+}
+
+qint64 TimeSeriesStore::tierResolution(int tier)
+{
+    return tier >= 0 && tier < TierCount ? TierResolutions[tier] : 0;
+}
+
+int TimeSeriesStore::tierCapacity(int tier)
+{
+    return tier >= 0 && tier < TierCount ? TierCapacities[tier] : 0;
+}
+
+int TimeSeriesStore::tierFor(qint64 msPerPixel)
+{
+    for (int tier = TierCount - 1; tier > Raw; --tier) {
+        if (TierResolutions[tier] <= msPerPixel) {
+            return tier;
+        }
+    }
+    return Raw;
+}
+
+qint64 TimeSeriesStore::tierStart(int ch, int tier) const
+{
+    if (tier == Raw) {
+        const Channel& channel = channels[ch];
+        if (!channel.sealed.isEmpty()) return channel.sealed.at(0).firstTimestamp();
+        if (!channel.open.isEmpty()) return channel.open.firstTimestamp();
+        return channel.ring.isEmpty() ? -1 : channel.ring.at(0).timestamp;
+    }
+    const RollupRing& ring = rollups(ch, tier);
+    return ring.isEmpty() ? -1 : ring.at(0).start;
+}
+
+void TimeSeriesStore::ensureChannel(int ch, const QString& key)
+{
+    if (ch < 0 || hasChannel(ch) || key.isEmpty()) return;
+    if (ch >= channels.size()) {
+        channels.resize(ch + 1);
+    }
+
+    Channel& channel = channels[ch];
+    channel.key = key;
+    channel.ring.setCapacity(defaultSize);
+    channel.sealed.setCapacity(sealedLimit);
+    for (int tier = Second; tier < TierCount; ++tier) {
+        channel.rollups[tier - 1].setCapacity(TierCapacities[tier]);
+    }
+}
+
+void TimeSeriesStore::setDefaultCapacity(int samples)
+{
+    defaultSize = samples > 0 ? samples : DefaultCapacity;
+    for (Channel& ch : channels) {
+        if (!ch.key.isEmpty() && ch.explicitCapacity <= 0) {
+            resizeRing(ch, defaultSize);
+        }
+    }
+}
+
+void TimeSeriesStore::setCapacity(int ch, int samples)
+{
+    if (!hasChannel(ch)) return;
+    Channel& channel = channels[ch];
+    channel.explicitCapacity = qMax(0, samples);
+    resizeRing(channel, channel.explicitCapacity > 0 ? channel.explicitCapacity : defaultSize);
+}
+
+void TimeSeriesStore::setSealedChunks(int chunks)
+{
+    sealedLimit = chunks > 0 ? chunks : DefaultSealedChunks;
+    for (Channel& ch : channels) {
+        if (ch.key.isEmpty()) continue;
+        for (int i = 0; i < ch.sealed.size() - sealedLimit; ++i) {
+            ch.dropped += ch.sealed.at(i).size();
+        }
+        ch.sealed.setCapacity(sealedLimit);
+    }
+}
+
+void TimeSeriesStore::resizeRing(Channel& channel, int capacity)
+{
+    // Отсчеты, не помещающиеся в уменьшенное кольцо, уходят в сжатую часть
+    SampleRing& ring = channel.ring;
+    for (int i = 0; i < ring.size() - qMax(1, capacity); ++i) {
+        compress(channel, ring.at(i));
+    }
+    ring.setCapacity(capacity);
+}
+
+void TimeSeriesStore::compress(Channel& channel, const Sample& sample)
+{
+    channel.open.append(sample.timestamp, sample.until, sample.value);
+    if (channel.open.size() >= ChunkSamples) {
+        channel.open.squeeze();
+        if (channel.sealed.size() == channel.sealed.capacity()) {
+            channel.dropped += channel.sealed.at(0).size();   // вытесняемый блок
+        }
+        channel.sealed.append(channel.open);
+        channel.open = GorillaChunk();
+    }
+}
+
+void TimeSeriesStore::setFormat(int ch, CellValue::Kind kind, const QString& unit)
+{
+    if (!hasChannel(ch)) return;
+    channels[ch].kind = kind;
+    channels[ch].unit = unit;
+}
+
+QString TimeSeriesStore::formatValue(int ch, double value) const
+{
+    CellValue v;
+    v.kind = channels[ch].kind;
+    v.number = value;
+    QString text = v.toString();
+    if (!channels[ch].unit.isEmpty()) {
+        text += " " + channels[ch].unit;
+    }
+    return text;
+}
+
+void TimeSeriesStore::append(int ch, qint64 timestamp, double value)
+{
+    if (!hasChannel(ch)) return;
+    Channel& channel = channels[ch];
+    SampleRing& ring = channel.ring;
+    const bool extension = !ring.isEmpty() && ring.last().value == value;
+    for (int tier = Second; tier < TierCount; ++tier) {
+        addToRollup(channel.rollups[tier - 1], TierResolutions[tier], timestamp, value, extension);
+    }
+
+    if (extension) {
+        Sample& last = ring.last();
+        last.until = qMax(last.until, timestamp);
+        return;
+    }
+    if (ring.size() == ring.capacity()) {
+        compress(channel, ring.at(0));   // вытесняемый отсчет
+    }
+    ring.append(Sample{timestamp, timestamp, value});
+    ++channel.appended;
+}
+
+qint64 TimeSeriesStore::memoryUsage() const
+{
+    qint64 total = 0;
+    for (const Channel& ch : channels) {
+        total += ch.ring.memoryUsage();
+        for (const RollupRing& rollup : ch.rollups) {
+            total += rollup.memoryUsage();
+        }
+        total += ch.open.memoryUsage();
+        for (int i = 0; i < ch.sealed.size(); ++i) {
+            total += ch.sealed.at(i).memoryUsage();
+        }
+    }
+    return total;
+}
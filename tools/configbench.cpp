@@ -0,0 +1,123 @@
+// Сравнение потокового разбора (JsonStreamReader) и DOM-разбора
+// (QJsonDocument) конфигурации и потока значений на больших конфигах.
+//
+// Запуск: ./hui_configbench [кол-во колонок] [ячеек в колонке]
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QTextStream>
+#include <functional>
+#include "configmanager.h"
+
+namespace {
+    QByteArray makeConfig(int columnCount, int cellsPerColumn)
+    {
+        QJsonArray columns;
+        for (int col = 0; col < columnCount; ++col) {
+            QJsonArray cells;
+            for (int cell = 0; cell < cellsPerColumn; ++cell) {
+                QJsonObject json;
+                json["content"] = QString("Напряжение на преобразователях %1").arg(cell);
+                QJsonArray subCells;
+                for (int sub = 0; sub < 2; ++sub) {
+                    QJsonObject subJson;
+                    subJson["content"] = sub == 0 ? "Линейный" : "Импульсный";
+                    subJson["value"] = QString::number(12.5 + sub + cell, 'f', 1);
+                    subJson["unit"] = "В";
+                    subCells.append(subJson);
+                }
+                json["subCells"] = subCells;
+                cells.append(json);
+            }
+            QJsonObject column;
+            column["name"] = QString("Колонка %1").arg(col);
+            column["cellCount"] = cellsPerColumn;
+            column["cells"] = cells;
+            columns.append(column);
+        }
+        QJsonObject root;
+        root["columns"] = columns;
+        return QJsonDocument(root).toJson(QJsonDocument::Compact);
+    }
+
+    QByteArray makeValues(const QList<ColumnConfig>& columns)
+    {
+        QJsonObject values;
+        for (int col = 0; col < columns.size(); ++col) {
+            for (int cell = 0; cell < columns[col].cells.size(); ++cell) {
+                const CellInfo& info = columns[col].cells[cell];
+                for (int sub = 0; sub < info.subCells.size(); ++sub) {
+                    values[info.subCells[sub].id] = 10.0 + col + cell * 0.01 + sub;
+                }
+            }
+        }
+        QJsonObject root;
+        root["values"] = values;
+        return QJsonDocument(root).toJson(QJsonDocument::Compact);
+    }
+
+    // Среднее время одного прогона в микросекундах
+    double measure(const std::function<void()>& body)
+    {
+        body(); // прогрев
+        QElapsedTimer timer;
+        int iterations = 0;
+        timer.start();
+        do {
+            body();
+            ++iterations;
+        } while (timer.elapsed() < 500);
+        return double(timer.nsecsElapsed()) / iterations / 1000.0;
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    const int columnCount = argc > 1 ? QString(argv[1]).toInt() : 10;
+    const int cellsPerColumn = argc > 2 ? QString(argv[2]).toInt() : 500;
+
+    const QByteArray config = makeConfig(columnCount, cellsPerColumn);
+    QList<ColumnConfig> layout;
+    if (!ConfigManager::parseConfig(config, "bench", layout)) {
+        out << "Ошибка разбора сгенерированного конфига\n";
+        return 1;
+    }
+    const CellIndex index = ConfigManager::buildCellIndex(layout);
+    const QByteArray values = makeValues(layout);
+
+    out << "Ячеек: " << columnCount * cellsPerColumn * 3
+        << ", конфиг: " << config.size() << " байт"
+        << ", значения: " << values.size() << " байт\n";
+
+    double domConfig = measure([&]() {
+        QList<ColumnConfig> result;
+        ConfigManager::parseConfigDom(config, "bench", result);
+    });
+    double streamConfig = measure([&]() {
+        QList<ColumnConfig> result;
+        ConfigManager::parseConfig(config, "bench", result);
+    });
+    double domValues = measure([&]() {
+        QList<ColumnConfig> result = layout;
+        ConfigManager::applyValuesDom(values, index, result);
+    });
+    double streamValues = measure([&]() {
+        QList<ColumnConfig> result = layout;
+        ConfigManager::applyValues(values, index, result);
+    });
+
+    out << qSetFieldWidth(24) << Qt::left << "" << qSetFieldWidth(14) << "DOM, мкс" << "поток, мкс" << "ускорение"
+        << qSetFieldWidth(0) << "\n";
+    out << qSetFieldWidth(24) << "config (columns)" << qSetFieldWidth(14)
+        << domConfig << streamConfig << domConfig / streamConfig << qSetFieldWidth(0) << "\n";
+    out << qSetFieldWidth(24) << "values" << qSetFieldWidth(14)
+        << domValues << streamValues << domValues / streamValues << qSetFieldWidth(0) << "\n";
+
+    return 0;
+}
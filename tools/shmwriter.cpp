@@ -0,0 +1,114 @@
+// Тестовый писатель разделяемого кольца (ShmRing): создает файл кольца
+// и пишет синусоиды в каналы с заданной частотой, пока его не остановят.
+// Каналы привязываются к ячейкам HUI по id, как ключи в values.json.
+//
+// Запуск: ./hui_shmwriter <файл> <отсчетов в секунду на канал> [id ...]
+// Например: ./hui_shmwriter /dev/shm/hui.ring 10000 0/0 0/1 0/2
+// В config.json HUI: "ingest": {"shm": "/dev/shm/hui.ring"}
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QThread>
+#include <QtMath>
+#include <csignal>
+#include "shmring.h"
+
+namespace {
+    const quint32 SlotCount = 1 << 16;   // на канал: больше секунды при 10 кГц
+    const int BatchMs = 1;               // пишем пачками раз в миллисекунду
+
+    volatile std::sig_atomic_t stopRequested = 0;
+
+    void onSignal(int)
+    {
+        stopRequested = 1;
+    }
+
+    // Старое кольцо помечается закрытым, чтобы читатель перешел на новое
+    void closeOldRing(const QString& path)
+    {
+        QFile old(path);
+        if (old.open(QIODevice::ReadWrite) && old.size() >= qint64(sizeof(ShmRing::Header))) {
+            if (uchar *mapped = old.map(0, sizeof(ShmRing::Header))) {
+                reinterpret_cast<ShmRing::Header*>(mapped)->magic.store(0, std::memory_order_release);
+                old.unmap(mapped);
+            }
+        }
+        old.close();
+        QFile::remove(path);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+    QStringList args = app.arguments();
+    if (args.size() < 3) {
+        out << "usage: hui_shmwriter <file> <samples per second> [id ...]\n";
+        return 1;
+    }
+
+    QString path = args[1];
+    double rate = qMax(1.0, args[2].toDouble());
+    QStringList ids = args.mid(3);
+    if (ids.isEmpty()) ids = QStringList{"0/0", "0/1", "0/2"};
+    quint32 channelCount = quint32(ids.size());
+
+    closeOldRing(path);
+    QFile file(path);
+    if (!file.open(QIODevice::ReadWrite) || !file.resize(ShmRing::fileSize(channelCount, SlotCount))) {
+        out << "cannot create " << path << ": " << file.errorString() << "\n";
+        return 1;
+    }
+    uchar *base = file.map(0, file.size());
+    if (!base) {
+        out << "cannot map " << path << "\n";
+        return 1;
+    }
+
+    // Файл после resize заполнен нулями: счетчики и seq уже 0
+    ShmRing::Header *header = reinterpret_cast<ShmRing::Header*>(base);
+    header->version = ShmRing::Version;
+    header->channelCount = channelCount;
+    header->slotCount = SlotCount;
+    for (quint32 ch = 0; ch < channelCount; ++ch) {
+        QByteArray id = ids[int(ch)].toUtf8().left(ShmRing::IdSize - 1);
+        std::memcpy(ShmRing::channel(base, ch)->id, id.constData(), size_t(id.size()));
+    }
+    header->magic.store(ShmRing::Magic, std::memory_order_release);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    out << "writing " << channelCount << " channels at " << rate << " samples/s to " << path << "\n";
+    out.flush();
+
+    // Отсчеты равномерно по времени: к моменту elapsed должно быть записано elapsed * rate
+    QElapsedTimer clock;
+    clock.start();
+    qint64 start = QDateTime::currentMSecsSinceEpoch();
+    quint64 written = 0;
+    while (!stopRequested) {
+        quint64 due = quint64(clock.nsecsElapsed() / 1e9 * rate);
+        for (; written < due; ++written) {
+            qint64 timestamp = start + qint64(written * 1000.0 / rate);
+            for (quint32 ch = 0; ch < channelCount; ++ch) {
+                double phase = written / rate * (0.2 + 0.1 * ch) * 2 * M_PI;
+                double value = 50 + 40 * qSin(phase);
+                ShmRing::write(ShmRing::channel(base, ch), ShmRing::slots(base, ch), SlotCount, timestamp, value);
+            }
+        }
+        QThread::msleep(BatchMs);
+    }
+
+    header->magic.store(0, std::memory_order_release);
+    file.unmap(base);
+    file.close();
+    QFile::remove(path);
+    out << "written " << written << " samples per channel\n";
+    return 0;
+}